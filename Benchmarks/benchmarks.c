@@ -0,0 +1,1195 @@
+/*
+ * benchmarks.c
+ *
+ * Kernel microbenchmarks, built in place of main.c and threads.c
+ *  - Prints one CSV row per measurement over the back channel UART, so runs can be compared across commits
+ *  - Times are in core clock cycles on the board and in nanoseconds on the host port, see the unit column
+ *  - 64 sleeping threads need a bigger kernel than the application's, build with
+ *    -DMAX_THREADS=72 -DSTACK_ARENA_SIZE=16384, rows that do not fit the thread table are left out
+ *  - The context_switch rows time PendSV_Handler with and without FPU context, so only the board prints them
+ *
+ * Host build from the repository root, not in simulation, where threads run in zero time:
+ *  gcc -std=gnu99 -O2 -fcommon -DG8RTOS_HOST -DMAX_THREADS=72 -DSTACK_ARENA_SIZE=16384 -IHostPort -IG8RTOS -I. \
+ *      G8RTOS/G8RTOS_*.c HostPort/HostBSP.c HostPort/G8RTOS_Port_Linux.c Benchmarks/benchmarks.c -o g8rtos_bench -lrt
+ */
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "msp.h"
+#include <driverlib.h>
+#include "BSP.h"
+#include "G8RTOS.h"
+#include "G8RTOS_Port.h"
+
+/*
+ * Kernel tick handler, timed directly by the tick benchmark
+ */
+extern void SysTick_Handler();
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+
+/*********************************************** Defines ******************************************************************************/
+
+#ifdef G8RTOS_HOST
+#define BENCH_UNIT "ns"
+#else
+#define BENCH_UNIT "cycles"
+#endif
+
+#define BENCH_SAMPLES 1000 //Samples of every short measurement
+#define BENCH_MESSAGES 10000 //Messages sent through the FIFO at each depth
+#define BENCH_FIFO_DEPTH 16 //Elements in the FIFO of the throughput benchmarks
+#define BENCH_STRESS_MESSAGES 12000 //Messages through the FIFO in every stress run, shared by the producers
+#define BENCH_STRESS_THREADS 4 //Most producers, and most consumers, of a stress run
+#define BENCH_BUFFER_SIZE 256 //Bytes in every buffer of the pool benchmarks, a whole UART line
+#define BENCH_SUBSCRIBERS 16 //Most subscribers of the topic benchmark
+#define BENCH_PERIOD 5 //Period in ms of the periodic events
+#define BENCH_RELEASES 200 //Releases of every periodic event that are measured
+#define BENCH_SLEEPERS 64 //Most sleeping threads parked at once
+#define BENCH_INVERSIONS 20 //Rounds of the priority inversion benchmark
+#define INVERSION_HOG_MS 3 //Time the medium priority thread keeps the CPU
+#define LOAD_SPIN_MS 50 //Time a thread keeps the CPU in the CPU load window
+#define LOAD_TOLERANCE 100 //Hundredths of a percent the CPU loads may add up to off 100%
+
+#define RUNNER_PRIORITY 1 //Above every thread it starts, below the timer thread
+#define WORKER_PRIORITY 2 //Threads being measured
+#define PARKED_PRIORITY 3 //Threads that only sleep
+#define MEDIUM_PRIORITY 4 //Priority inversion, thread that keeps the CPU without touching the bus
+#define LOW_PRIORITY 5 //Priority inversion, thread holding the bus
+
+#define RUNNER_STACKSIZE 1024 //snprintf needs room
+#define WORKER_STACKSIZE 512 //Room for the FPU context
+#define PARKED_STACKSIZE MIN_STACKSIZE
+
+/*********************************************** Defines ******************************************************************************/
+
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+/* Statistics of one measurement */
+typedef struct
+{
+    uint32_t samples;
+    uint64_t min;
+    uint64_t max;
+    uint64_t sum;
+}benchStats_t;
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+
+/*********************************************** Private Variables ********************************************************************/
+
+/* Configuration for UART */
+static const eUSCI_UART_Config Uart115200Config =
+{
+    EUSCI_A_UART_CLOCKSOURCE_SMCLK, //SMCLK Clock Source
+    6, // BRDIV
+    8, // UCxBRF
+    0, // UCxBRS
+    EUSCI_A_UART_NO_PARITY, // No Parity
+    EUSCI_A_UART_LSB_FIRST, //LSB First
+    EUSCI_A_UART_ONE_STOP_BIT, // One stop bit
+    EUSCI_A_UART_MODE, // UART mode
+    EUSCI_A_UART_OVERSAMPLING_BAUDRATE_GENERATION // Oversampling
+};
+
+/* Core clock cycles in one tick */
+static uint32_t CyclesPerTick;
+
+/* Statistics the worker threads fill in */
+static benchStats_t Stats;
+
+/* Context switch, cycle count and thread just before a switch, whether the workers touch the FPU */
+static volatile uint32_t SwitchStamp;
+static volatile threadId_t SwitchFrom;
+static bool SwitchUseFpu;
+static volatile float FpuScratch = 1.0f;
+
+/* Semaphore round trip */
+static semaphore_t Ping;
+static semaphore_t Pong;
+
+/* FIFO throughput, FIFO and its storage, free places the producer may fill and time the last message was read */
+static fifoHandle_t BenchFifo;
+static uint32_t BenchFifoBuffer[BENCH_FIFO_DEPTH];
+static semaphore_t FifoCredits;
+static uint64_t FifoDone;
+
+/* FIFO handoff, when the reader in front gave up and when the reader behind it got its data */
+static uint64_t HandoffLeft;
+static uint64_t HandoffGot;
+
+/* FIFO stress, messages per producer and per consumer, next producer number and the sum of all messages read */
+static uint32_t StressPerProducer;
+static uint32_t StressPerConsumer;
+static uint32_t NextProducer;
+static uint64_t StressSum;
+
+/* FIFO batches, messages moved by every batched write and read */
+static uint32_t BatchSize;
+
+/* Buffer pool, and a FIFO of its buffers */
+static pool_t BenchPool;
+static POOL_STORAGE(BenchPoolStorage, BENCH_FIFO_DEPTH, BENCH_BUFFER_SIZE);
+static void *BenchPoolFifoBuffer[BENCH_FIFO_DEPTH];
+
+/* Topic, its ring and its subscribers, the next subscriber thread's number and the samples they have read */
+static topicHandle_t BenchTopic;
+static uint32_t BenchTopicBuffer[BENCH_FIFO_DEPTH];
+static subscriber_t BenchSubscribers[BENCH_SUBSCRIBERS];
+static uint32_t NextSubscriber;
+static volatile uint32_t TopicReads;
+
+/* Priority inversion, bus shared by the high and low priority threads, and what they lock it with */
+static mutex_t BusMutex;
+static semaphore_t BusSemaphore;
+static bool BusUseMutex;
+static semaphore_t LowGo;
+static semaphore_t MediumGo;
+
+/* Sleeping threads parked for the scaling benchmarks */
+static threadId_t Parked[BENCH_SLEEPERS];
+static uint32_t NumberOfParked;
+
+/* Sleep benchmark, milliseconds every sleep lasts, and whether it is a timed wait on a semaphore nobody signals */
+static uint32_t SleepMs;
+static bool SleepUseWait;
+static semaphore_t Never;
+
+/* Periodic benchmark, statistics and first release tick of each event */
+static benchStats_t ShortStats;
+static benchStats_t DeferredStats;
+static uint64_t ShortFirstTick;
+static uint64_t DeferredFirstTick;
+
+/* CPU load snapshot, too big for the runner's stack */
+static cpuLoad_t CpuLoad;
+
+/*********************************************** Private Variables ********************************************************************/
+
+
+/*********************************************** Private Functions ********************************************************************/
+
+/*
+ * Initializes the USART
+ */
+static void uartInit()
+{
+    /* select the GPIO functionality */
+    MAP_GPIO_setAsPeripheralModuleFunctionInputPin(GPIO_PORT_P1, GPIO_PIN2 | GPIO_PIN3, GPIO_PRIMARY_MODULE_FUNCTION);
+
+    /* configure the digital oscillator */
+    CS_setDCOCenteredFrequency(CS_DCO_FREQUENCY_12);
+
+    /* configure the UART with baud rate 115200 */
+    MAP_UART_initModule(EUSCI_A0_BASE, &Uart115200Config);
+
+    /* enable the UART */
+    MAP_UART_enableModule(EUSCI_A0_BASE);
+}
+
+/* method to transmit a string through USART, the trace thread sends its batches on the same UART */
+static void uartTransmitString(const char *s)
+{
+    G8RTOS_LockMutex(&G8RTOS_BackChannelMutex);
+
+    /* Loop while not null */
+    while(*s)
+    {
+        MAP_UART_transmitData(EUSCI_A0_BASE, *s++);
+    }
+
+    G8RTOS_UnlockMutex(&G8RTOS_BackChannelMutex);
+}
+
+/*
+ * Starts a measurement over
+ */
+static void StatsReset(benchStats_t *stats)
+{
+    stats->samples = 0;
+    stats->min = UINT64_MAX;
+    stats->max = 0;
+    stats->sum = 0;
+}
+
+/*
+ * Adds one sample to a measurement
+ */
+static void StatsAdd(benchStats_t *stats, uint64_t sample)
+{
+    stats->samples++;
+    stats->sum += sample;
+    if(sample < stats->min)
+    {
+        stats->min = sample;
+    }
+    if(sample > stats->max)
+    {
+        stats->max = sample;
+    }
+}
+
+/*
+ * Prints one CSV row
+ * Param "name", "parameter": what was measured and how
+ * Param "stats": samples, nothing is printed without any
+ */
+static void PrintRow(const char *name, const char *parameter, benchStats_t *stats)
+{
+    char row[128];
+
+    if(stats->samples == 0)
+    {
+        return;
+    }
+
+    snprintf(row, sizeof(row), "%s,%s,%lu,%llu,%llu,%llu,%s\n\r", name, parameter, (unsigned long)stats->samples,
+             (unsigned long long)stats->min, (unsigned long long)(stats->sum / stats->samples), (unsigned long long)stats->max, BENCH_UNIT);
+    uartTransmitString(row);
+}
+
+/*
+ * Cycles since launch of the tick boundary at or before "cycles"
+ */
+static uint64_t TickFloor(uint64_t cycles)
+{
+    return cycles - (cycles % CyclesPerTick);
+}
+
+/*
+ * Context switch worker, two run at the same priority and yield to each other
+ *  - Each one times the switch from the other one, switches back to itself are not counted
+ */
+static void SwitchWorker(void)
+{
+    threadId_t self = G8RTOS_GetThreadId();
+
+    for(uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        //Makes the FPU context live, so it is stacked on the switch
+        if(SwitchUseFpu)
+        {
+            FpuScratch = FpuScratch * 1.0001f;
+        }
+
+        SwitchFrom = self;
+        SwitchStamp = G8RTOS_GetCycleCount();
+        G8RTOS_PendSV();
+        uint32_t now = G8RTOS_GetCycleCount();
+
+        if(SwitchFrom != self)
+        {
+            StatsAdd(&Stats, now - SwitchStamp);
+        }
+    }
+}
+
+/*
+ * Times context switches between two threads
+ * Param "useFpu": whether both threads use the FPU
+ */
+static void RunContextSwitch(bool useFpu)
+{
+    StatsReset(&Stats);
+    SwitchUseFpu = useFpu;
+
+    threadId_t a = G8RTOS_AddThread(&SwitchWorker, WORKER_PRIORITY, WORKER_STACKSIZE);
+    threadId_t b = G8RTOS_AddThread(&SwitchWorker, WORKER_PRIORITY, WORKER_STACKSIZE);
+    G8RTOS_JoinThread(a);
+    G8RTOS_JoinThread(b);
+}
+
+/*
+ * Parked thread, sleeps until it is killed
+ */
+static void ParkedThread(void)
+{
+    while(1)
+    {
+        G8RTOS_Sleep(0x40000000);
+    }
+}
+
+/*
+ * Parks sleeping threads until there are "count", as many as the thread table holds
+ * Returns: true if all of them fit
+ */
+static bool Park(uint32_t count)
+{
+    while(NumberOfParked < count)
+    {
+        threadId_t id = G8RTOS_AddThread(&ParkedThread, PARKED_PRIORITY, PARKED_STACKSIZE);
+        if(id == ERROR)
+        {
+            break;
+        }
+        Parked[NumberOfParked++] = id;
+    }
+
+    //Lets every new one reach its sleep
+    G8RTOS_Sleep(2);
+
+    return NumberOfParked == count;
+}
+
+/*
+ * Kills every parked thread
+ */
+static void Unpark(void)
+{
+    while(NumberOfParked != 0)
+    {
+        G8RTOS_KillThread(Parked[--NumberOfParked]);
+    }
+}
+
+/*
+ * Times the tick handler with the parked threads asleep
+ *  - Every call is one extra tick, which only moves SystemTime ahead
+ */
+static void RunTickHandler(void)
+{
+    StatsReset(&Stats);
+
+    for(uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        int32_t priMask = StartCriticalSection();
+
+        uint32_t start = G8RTOS_GetCycleCount();
+        SysTick_Handler();
+        uint32_t end = G8RTOS_GetCycleCount();
+
+        EndCriticalSection(priMask);
+
+        StatsAdd(&Stats, end - start);
+    }
+}
+
+/*
+ * Semaphore round trip, pinging side
+ */
+static void PingWorker(void)
+{
+    for(uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        uint32_t start = G8RTOS_GetCycleCount();
+        G8RTOS_SignalSemaphore(&Ping);
+        G8RTOS_WaitSemaphore(&Pong);
+        StatsAdd(&Stats, G8RTOS_GetCycleCount() - start);
+    }
+}
+
+/*
+ * Semaphore round trip, answering side
+ */
+static void PongWorker(void)
+{
+    for(uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        G8RTOS_WaitSemaphore(&Ping);
+        G8RTOS_SignalSemaphore(&Pong);
+    }
+}
+
+/*
+ * Times a signal and wait round trip between two threads
+ */
+static void RunSemaphore(void)
+{
+    StatsReset(&Stats);
+    G8RTOS_InitSemaphore(&Ping, 0, SEMAPHORE_FIFO);
+    G8RTOS_InitSemaphore(&Pong, 0, SEMAPHORE_FIFO);
+
+    threadId_t pong = G8RTOS_AddThread(&PongWorker, WORKER_PRIORITY, WORKER_STACKSIZE);
+    threadId_t ping = G8RTOS_AddThread(&PingWorker, WORKER_PRIORITY, WORKER_STACKSIZE);
+    G8RTOS_JoinThread(ping);
+    G8RTOS_JoinThread(pong);
+}
+
+/*
+ * FIFO producer, never writes more messages than there are credits
+ */
+static void FifoProducer(void)
+{
+    for(uint32_t i = 0; i < BENCH_MESSAGES; i++)
+    {
+        G8RTOS_WaitSemaphore(&FifoCredits);
+        writeFIFO(BenchFifo, &i);
+    }
+}
+
+/*
+ * FIFO consumer, gives a credit back for every message
+ */
+static void FifoConsumer(void)
+{
+    uint32_t data;
+
+    for(uint32_t i = 0; i < BENCH_MESSAGES; i++)
+    {
+        readFIFO(BenchFifo, &data);
+        G8RTOS_SignalSemaphore(&FifoCredits);
+    }
+    FifoDone = G8RTOS_GetTimeCycles();
+}
+
+/*
+ * Sends BENCH_MESSAGES messages through a FIFO holding at most "depth" of them
+ * Param "depth": messages in flight, at most BENCH_FIFO_DEPTH
+ * Param "mode": FIFO_MPMC or FIFO_SPSC, SPSC rows are named spsc/depth
+ */
+static void RunFifo(uint32_t depth, fifoMode_t mode)
+{
+    char parameter[24];
+
+    BenchFifo = G8RTOS_CreateFIFO(BenchFifoBuffer, BENCH_FIFO_DEPTH, sizeof(uint32_t), mode, FIFO_DROP_NEWEST);
+    G8RTOS_InitSemaphore(&FifoCredits, depth, SEMAPHORE_FIFO);
+
+    uint64_t start = G8RTOS_GetTimeCycles();
+    threadId_t consumer = G8RTOS_AddThread(&FifoConsumer, WORKER_PRIORITY, WORKER_STACKSIZE);
+    threadId_t producer = G8RTOS_AddThread(&FifoProducer, WORKER_PRIORITY, WORKER_STACKSIZE);
+    G8RTOS_JoinThread(producer);
+    G8RTOS_JoinThread(consumer);
+    G8RTOS_DeleteFIFO(BenchFifo);
+
+    uint64_t cycles = FifoDone - start;
+    snprintf(parameter, sizeof(parameter), "%sdepth=%lu", (mode == FIFO_SPSC) ? "spsc/" : "", (unsigned long)depth);
+
+    //Only the whole run is timed, so there is a mean but no min or max
+    char row[128];
+    snprintf(row, sizeof(row), "fifo_message,%s,%lu,,%llu,,%s\n\r", parameter, (unsigned long)BENCH_MESSAGES,
+             (unsigned long long)(cycles / BENCH_MESSAGES), BENCH_UNIT);
+    uartTransmitString(row);
+    snprintf(row, sizeof(row), "fifo_throughput,%s,%lu,,%llu,,msg/s\n\r", parameter, (unsigned long)BENCH_MESSAGES,
+             (unsigned long long)((uint64_t)BENCH_MESSAGES * ClockSys_GetSysFreq() / cycles));
+    uartTransmitString(row);
+}
+
+/*
+ * FIFO handoff reader in front, waits for more than is ever written
+ */
+static void HandoffFront(void)
+{
+    uint32_t data[BENCH_FIFO_DEPTH];
+
+    readFIFOBlock(BenchFifo, data, BENCH_FIFO_DEPTH, BENCH_FIFO_DEPTH, BENCH_PERIOD);
+    HandoffLeft = G8RTOS_GetTimeCycles();
+}
+
+/*
+ * FIFO handoff reader behind, only needs one element
+ */
+static void HandoffBehind(void)
+{
+    uint32_t data;
+
+    if(readFIFOTimeout(BenchFifo, &data, 20 * BENCH_PERIOD) == SUCCESS)
+    {
+        HandoffGot = G8RTOS_GetTimeCycles();
+    }
+}
+
+/*
+ * Checks that a reader blocked behind one that leaves without being woken still gets the data there is,
+ * and times how long it takes to get it
+ * Param "kill": the reader in front is killed instead of timing out
+ */
+static void RunFifoHandoff(bool kill)
+{
+    uint32_t data[3] = { 1, 2, 3 };
+    char row[128];
+
+    BenchFifo = G8RTOS_CreateFIFO(BenchFifoBuffer, BENCH_FIFO_DEPTH, sizeof(uint32_t), FIFO_MPMC, FIFO_DROP_NEWEST);
+    HandoffLeft = 0;
+    HandoffGot = 0;
+
+    //Both readers block in order, then less is written than the front one waits for
+    threadId_t front = G8RTOS_AddThread(&HandoffFront, WORKER_PRIORITY, WORKER_STACKSIZE);
+    G8RTOS_Sleep(1);
+    threadId_t behind = G8RTOS_AddThread(&HandoffBehind, WORKER_PRIORITY, WORKER_STACKSIZE);
+    G8RTOS_Sleep(1);
+    writeFIFOBlock(BenchFifo, data, 3, 0);
+
+    if(kill)
+    {
+        HandoffLeft = G8RTOS_GetTimeCycles();
+        G8RTOS_KillThread(front);
+    }
+    G8RTOS_JoinThread(front);
+    G8RTOS_JoinThread(behind);
+    G8RTOS_DeleteFIFO(BenchFifo);
+
+    if(HandoffGot == 0)
+    {
+        snprintf(row, sizeof(row), "fifo_handoff,%s,1,,,,lost wakeup\n\r", kill ? "kill" : "timeout");
+        uartTransmitString(row);
+        return;
+    }
+    snprintf(row, sizeof(row), "fifo_handoff,%s,1,,%llu,,%s\n\r", kill ? "kill" : "timeout",
+             (unsigned long long)(HandoffGot - HandoffLeft), BENCH_UNIT);
+    uartTransmitString(row);
+}
+
+/*
+ * Times a single write into an empty FIFO with no reader waiting, what an interrupt producer pays
+ * Param "mode": FIFO_MPMC or FIFO_SPSC
+ */
+static void RunFifoWrite(fifoMode_t mode)
+{
+    uint32_t data;
+
+    StatsReset(&Stats);
+    BenchFifo = G8RTOS_CreateFIFO(BenchFifoBuffer, BENCH_FIFO_DEPTH, sizeof(uint32_t), mode, FIFO_DROP_NEWEST);
+
+    for(uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        uint32_t start = G8RTOS_GetCycleCount();
+        writeFIFO(BenchFifo, &i);
+        StatsAdd(&Stats, G8RTOS_GetCycleCount() - start);
+
+        tryReadFIFO(BenchFifo, &data);
+    }
+    G8RTOS_DeleteFIFO(BenchFifo);
+}
+
+/*
+ * Times handing a buffer through a FIFO of buffers, allocating, sending, receiving and releasing it
+ *  - Only the pointer is copied, so the time is the same for any buffer size
+ */
+static void RunPool(void)
+{
+    StatsReset(&Stats);
+    G8RTOS_InitPool(&BenchPool, BenchPoolStorage, BENCH_FIFO_DEPTH, BENCH_BUFFER_SIZE);
+    BenchFifo = G8RTOS_CreateFIFO(BenchPoolFifoBuffer, BENCH_FIFO_DEPTH, sizeof(void *), FIFO_MPMC, FIFO_DROP_NEWEST);
+
+    for(uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        uint32_t start = G8RTOS_GetCycleCount();
+        G8RTOS_SendBuffer(BenchFifo, G8RTOS_AllocBuffer(&BenchPool, 0), 0);
+        G8RTOS_ReleaseBuffer(G8RTOS_ReceiveBuffer(BenchFifo, 0));
+        StatsAdd(&Stats, G8RTOS_GetCycleCount() - start);
+    }
+    G8RTOS_DeleteFIFO(BenchFifo);
+}
+
+/*
+ * Topic subscriber, blocks for every sample until it is killed
+ */
+static void TopicSubscriber(void)
+{
+    uint32_t data;
+
+    int32_t priMask = StartCriticalSection();
+    subscriber_t *s = &BenchSubscribers[NextSubscriber++];
+    EndCriticalSection(priMask);
+
+    while(1)
+    {
+        G8RTOS_ReadTopic(s, &data, WAIT_FOREVER);
+
+        priMask = StartCriticalSection();
+        TopicReads++;
+        EndCriticalSection(priMask);
+    }
+}
+
+/*
+ * Times publishing a sample with every subscriber blocked waiting for it
+ *  - Subscribers run below the runner, so the time covers waking all of them and none of their reading
+ * Param "subscribers": subscriber threads, at most BENCH_SUBSCRIBERS, the row is left out if they do not fit
+ */
+static void RunTopic(uint32_t subscribers)
+{
+    threadId_t threads[BENCH_SUBSCRIBERS];
+    uint32_t count = 0;
+
+    StatsReset(&Stats);
+    if(BenchTopic == 0)
+    {
+        BenchTopic = G8RTOS_CreateTopic("bench", BenchTopicBuffer, BENCH_FIFO_DEPTH, sizeof(uint32_t));
+    }
+    for(uint32_t i = 0; i < subscribers; i++)
+    {
+        G8RTOS_Subscribe(&BenchSubscribers[i], BenchTopic);
+    }
+    NextSubscriber = 0;
+    TopicReads = 0;
+
+    while(count < subscribers)
+    {
+        threadId_t id = G8RTOS_AddThread(&TopicSubscriber, WORKER_PRIORITY, WORKER_STACKSIZE);
+        if(id == ERROR)
+        {
+            break;
+        }
+        threads[count++] = id;
+    }
+
+    //Lets every one of them block
+    G8RTOS_Sleep(2);
+
+    for(uint32_t i = 0; count == subscribers && i < BENCH_SAMPLES; i++)
+    {
+        uint32_t start = G8RTOS_GetCycleCount();
+        G8RTOS_Publish(BenchTopic, &i);
+        StatsAdd(&Stats, G8RTOS_GetCycleCount() - start);
+
+        //Every subscriber has read it and blocked again before the next one
+        while(TopicReads != (i + 1) * subscribers)
+        {
+            G8RTOS_Sleep(1);
+        }
+    }
+
+    while(count != 0)
+    {
+        G8RTOS_KillThread(threads[--count]);
+    }
+}
+
+/*
+ * FIFO stress producer, writes its own range of messages, blocking while the FIFO is full
+ */
+static void StressProducer(void)
+{
+    int32_t priMask = StartCriticalSection();
+    uint32_t first = NextProducer++ * StressPerProducer + 1;
+    EndCriticalSection(priMask);
+
+    for(uint32_t i = first; i < first + StressPerProducer; i++)
+    {
+        writeFIFO(BenchFifo, &i);
+    }
+}
+
+/*
+ * FIFO stress consumer, adds up its share of the messages
+ */
+static void StressConsumer(void)
+{
+    uint64_t sum = 0;
+    uint32_t data;
+
+    for(uint32_t i = 0; i < StressPerConsumer; i++)
+    {
+        readFIFO(BenchFifo, &data);
+        sum += data;
+    }
+
+    int32_t priMask = StartCriticalSection();
+    StressSum += sum;
+    EndCriticalSection(priMask);
+}
+
+/*
+ * Sends BENCH_STRESS_MESSAGES messages through a FIFO_BLOCK FIFO from several producers to several consumers
+ *  - Every message is a different number, so the sum read shows a lost or doubled one
+ * Param "producers", "consumers": threads on each side, at most BENCH_STRESS_THREADS and dividing BENCH_STRESS_MESSAGES
+ */
+static void RunFifoStress(uint32_t producers, uint32_t consumers)
+{
+    threadId_t threads[2 * BENCH_STRESS_THREADS];
+    uint32_t count = 0;
+    char parameter[24];
+    char row[128];
+
+    BenchFifo = G8RTOS_CreateFIFO(BenchFifoBuffer, BENCH_FIFO_DEPTH, sizeof(uint32_t), FIFO_MPMC, FIFO_BLOCK);
+    StressPerProducer = BENCH_STRESS_MESSAGES / producers;
+    StressPerConsumer = BENCH_STRESS_MESSAGES / consumers;
+    NextProducer = 0;
+    StressSum = 0;
+
+    uint64_t start = G8RTOS_GetTimeCycles();
+    for(uint32_t i = 0; i < consumers; i++)
+    {
+        threads[count++] = G8RTOS_AddThread(&StressConsumer, WORKER_PRIORITY, WORKER_STACKSIZE);
+    }
+    for(uint32_t i = 0; i < producers; i++)
+    {
+        threads[count++] = G8RTOS_AddThread(&StressProducer, WORKER_PRIORITY, WORKER_STACKSIZE);
+    }
+    for(uint32_t i = 0; i < count; i++)
+    {
+        G8RTOS_JoinThread(threads[i]);
+    }
+    G8RTOS_DeleteFIFO(BenchFifo);
+    uint64_t cycles = G8RTOS_GetTimeCycles() - start;
+
+    snprintf(parameter, sizeof(parameter), "%lux%lu", (unsigned long)producers, (unsigned long)consumers);
+
+    //Sum of 1 to BENCH_STRESS_MESSAGES
+    if(StressSum != (uint64_t)BENCH_STRESS_MESSAGES * (BENCH_STRESS_MESSAGES + 1) / 2)
+    {
+        snprintf(row, sizeof(row), "fifo_stress,%s,%lu,,,,lost or doubled messages\n\r", parameter, (unsigned long)BENCH_STRESS_MESSAGES);
+        uartTransmitString(row);
+        return;
+    }
+    snprintf(row, sizeof(row), "fifo_stress,%s,%lu,,%llu,,%s\n\r", parameter, (unsigned long)BENCH_STRESS_MESSAGES,
+             (unsigned long long)(cycles / BENCH_STRESS_MESSAGES), BENCH_UNIT);
+    uartTransmitString(row);
+    snprintf(row, sizeof(row), "fifo_stress_throughput,%s,%lu,,%llu,,msg/s\n\r", parameter, (unsigned long)BENCH_STRESS_MESSAGES,
+             (unsigned long long)((uint64_t)BENCH_STRESS_MESSAGES * ClockSys_GetSysFreq() / cycles));
+    uartTransmitString(row);
+}
+
+/*
+ * FIFO batch producer, writes BatchSize messages at a time, blocking while the FIFO is full
+ */
+static void BatchProducer(void)
+{
+    uint32_t data[BENCH_FIFO_DEPTH];
+
+    for(uint32_t i = 0; i < BENCH_MESSAGES; i += BatchSize)
+    {
+        for(uint32_t j = 0; j < BatchSize; j++)
+        {
+            data[j] = i + j + 1;
+        }
+        writeFIFOBlock(BenchFifo, data, BatchSize, WAIT_FOREVER);
+    }
+}
+
+/*
+ * FIFO batch consumer, reads BatchSize messages at a time and adds them up
+ */
+static void BatchConsumer(void)
+{
+    uint32_t data[BENCH_FIFO_DEPTH];
+    uint64_t sum = 0;
+
+    for(uint32_t i = 0; i < BENCH_MESSAGES; i += BatchSize)
+    {
+        readFIFOBlock(BenchFifo, data, BatchSize, BatchSize, WAIT_FOREVER);
+        for(uint32_t j = 0; j < BatchSize; j++)
+        {
+            sum += data[j];
+        }
+    }
+    StressSum = sum;
+    FifoDone = G8RTOS_GetTimeCycles();
+}
+
+/*
+ * Sends BENCH_MESSAGES messages through a FIFO_BLOCK FIFO, "batch" of them with every write and read
+ * Param "batch": messages per call, at most BENCH_FIFO_DEPTH and dividing BENCH_MESSAGES
+ */
+static void RunFifoBatch(uint32_t batch)
+{
+    char parameter[24];
+    char row[128];
+
+    BenchFifo = G8RTOS_CreateFIFO(BenchFifoBuffer, BENCH_FIFO_DEPTH, sizeof(uint32_t), FIFO_MPMC, FIFO_BLOCK);
+    BatchSize = batch;
+
+    uint64_t start = G8RTOS_GetTimeCycles();
+    threadId_t consumer = G8RTOS_AddThread(&BatchConsumer, WORKER_PRIORITY, WORKER_STACKSIZE);
+    threadId_t producer = G8RTOS_AddThread(&BatchProducer, WORKER_PRIORITY, WORKER_STACKSIZE);
+    G8RTOS_JoinThread(producer);
+    G8RTOS_JoinThread(consumer);
+    G8RTOS_DeleteFIFO(BenchFifo);
+
+    uint64_t cycles = FifoDone - start;
+    snprintf(parameter, sizeof(parameter), "n=%lu", (unsigned long)batch);
+
+    //Sum of 1 to BENCH_MESSAGES
+    if(StressSum != (uint64_t)BENCH_MESSAGES * (BENCH_MESSAGES + 1) / 2)
+    {
+        snprintf(row, sizeof(row), "fifo_batch,%s,%lu,,,,lost or doubled messages\n\r", parameter, (unsigned long)BENCH_MESSAGES);
+        uartTransmitString(row);
+        return;
+    }
+    snprintf(row, sizeof(row), "fifo_batch,%s,%lu,,%llu,,%s\n\r", parameter, (unsigned long)BENCH_MESSAGES,
+             (unsigned long long)(cycles / BENCH_MESSAGES), BENCH_UNIT);
+    uartTransmitString(row);
+    snprintf(row, sizeof(row), "fifo_batch_throughput,%s,%lu,,%llu,,msg/s\n\r", parameter, (unsigned long)BENCH_MESSAGES,
+             (unsigned long long)((uint64_t)BENCH_MESSAGES * ClockSys_GetSysFreq() / cycles));
+    uartTransmitString(row);
+}
+
+/*
+ * Keeps the CPU busy
+ * Param "cycles": time to spin for
+ */
+static void Spin(uint64_t cycles)
+{
+    uint64_t end = G8RTOS_GetTimeCycles() + cycles;
+
+    while(G8RTOS_GetTimeCycles() < end);
+}
+
+static void BusLock(void)
+{
+    if(BusUseMutex)
+    {
+        G8RTOS_LockMutex(&BusMutex);
+    }
+    else
+    {
+        G8RTOS_WaitSemaphore(&BusSemaphore);
+    }
+}
+
+static void BusUnlock(void)
+{
+    if(BusUseMutex)
+    {
+        G8RTOS_UnlockMutex(&BusMutex);
+    }
+    else
+    {
+        G8RTOS_SignalSemaphore(&BusSemaphore);
+    }
+}
+
+/*
+ * Priority inversion, high priority side
+ *  - Lets the low priority thread take the bus and sleeps, then times how long it waits for the bus
+ */
+static void InversionHigh(void)
+{
+    for(uint32_t i = 0; i < BENCH_INVERSIONS; i++)
+    {
+        G8RTOS_SignalSemaphore(&LowGo);
+        G8RTOS_Sleep(1);
+
+        uint64_t start = G8RTOS_GetTimeCycles();
+        BusLock();
+        StatsAdd(&Stats, G8RTOS_GetTimeCycles() - start);
+        BusUnlock();
+
+        //Lets the other two finish the round
+        G8RTOS_Sleep(INVERSION_HOG_MS + 3);
+    }
+}
+
+/*
+ * Priority inversion, medium priority side, keeps the CPU away from the low priority thread
+ */
+static void InversionMedium(void)
+{
+    for(uint32_t i = 0; i < BENCH_INVERSIONS; i++)
+    {
+        G8RTOS_WaitSemaphore(&MediumGo);
+        Spin((uint64_t)G8RTOS_MsToTicks(INVERSION_HOG_MS) * CyclesPerTick);
+    }
+}
+
+/*
+ * Priority inversion, low priority side
+ *  - Takes the bus, wakes the medium priority thread and holds the bus for a tick and a half once it runs again
+ */
+static void InversionLow(void)
+{
+    for(uint32_t i = 0; i < BENCH_INVERSIONS; i++)
+    {
+        G8RTOS_WaitSemaphore(&LowGo);
+        BusLock();
+        G8RTOS_SignalSemaphore(&MediumGo);
+        Spin(CyclesPerTick * 3 / 2);
+        BusUnlock();
+    }
+}
+
+/*
+ * Times the worst case wait of a high priority thread for a bus a low priority thread holds
+ *  - A medium priority thread becomes ready while the bus is held and keeps the CPU for INVERSION_HOG_MS
+ * Param "useMutex": whether the bus is locked with a mutex, or with a semaphore that has no owner
+ * Param "ceiling": ceiling of the mutex
+ */
+static void RunInversion(bool useMutex, uint8_t ceiling)
+{
+    StatsReset(&Stats);
+    BusUseMutex = useMutex;
+    G8RTOS_InitMutex(&BusMutex, ceiling);
+    G8RTOS_InitSemaphore(&BusSemaphore, 1, SEMAPHORE_PRIORITY);
+    G8RTOS_InitSemaphore(&LowGo, 0, SEMAPHORE_FIFO);
+    G8RTOS_InitSemaphore(&MediumGo, 0, SEMAPHORE_FIFO);
+
+    threadId_t low = G8RTOS_AddThread(&InversionLow, LOW_PRIORITY, WORKER_STACKSIZE);
+    threadId_t medium = G8RTOS_AddThread(&InversionMedium, MEDIUM_PRIORITY, WORKER_STACKSIZE);
+    threadId_t high = G8RTOS_AddThread(&InversionHigh, WORKER_PRIORITY, WORKER_STACKSIZE);
+    G8RTOS_JoinThread(high);
+    G8RTOS_JoinThread(medium);
+    G8RTOS_JoinThread(low);
+}
+
+/*
+ * Sleeps again and again, timing how late it wakes up after the tick it was due on
+ */
+static void SleepWorker(void)
+{
+    //Starts right after a tick so no tick comes between reading the time and sleeping
+    G8RTOS_Sleep(1);
+
+    for(uint32_t i = 0; i < BENCH_SAMPLES / 10; i++)
+    {
+        uint64_t due = TickFloor(G8RTOS_GetTimeCycles()) + (uint64_t)G8RTOS_MsToTicks(SleepMs) * CyclesPerTick;
+        if(SleepUseWait)
+        {
+            G8RTOS_WaitSemaphoreTimeout(&Never, SleepMs);
+        }
+        else
+        {
+            G8RTOS_Sleep(SleepMs);
+        }
+        uint64_t now = G8RTOS_GetTimeCycles();
+
+        if(now >= due)
+        {
+            StatsAdd(&Stats, now - due);
+        }
+    }
+}
+
+/*
+ * Times how late G8RTOS_Sleep, or a timed wait that runs out, wakes a thread
+ * Param "ms": length of every sleep
+ * Param "useWait": whether to time a semaphore wait timing out instead of a sleep
+ */
+static void RunSleep(uint32_t ms, bool useWait)
+{
+    StatsReset(&Stats);
+    SleepMs = ms;
+    SleepUseWait = useWait;
+    G8RTOS_InitSemaphore(&Never, 0, SEMAPHORE_FIFO);
+
+    G8RTOS_JoinThread(G8RTOS_AddThread(&SleepWorker, WORKER_PRIORITY, WORKER_STACKSIZE));
+}
+
+/*
+ * Times how late a release of a periodic event runs after its release tick
+ *  - The release grid is taken from the first release, later ones are a whole number of periods after it
+ */
+static void PeriodicLateness(benchStats_t *stats, uint64_t *firstTick)
+{
+    if(stats->samples >= BENCH_RELEASES)
+    {
+        return;
+    }
+
+    uint64_t now = G8RTOS_GetTimeCycles();
+    uint64_t periodCycles = (uint64_t)G8RTOS_MsToTicks(BENCH_PERIOD) * CyclesPerTick;
+
+    if(*firstTick == 0)
+    {
+        *firstTick = TickFloor(now);
+    }
+
+    //Release time is the last grid point before now, so releases the overrun policy merged are not counted as late
+    uint64_t released = *firstTick + (now - *firstTick) / periodCycles * periodCycles;
+    StatsAdd(stats, now - released);
+}
+
+static void ShortHandler(void)
+{
+    PeriodicLateness(&ShortStats, &ShortFirstTick);
+}
+
+static void DeferredHandler(void)
+{
+    PeriodicLateness(&DeferredStats, &DeferredFirstTick);
+}
+
+/*
+ * Times periodic releases in the SysTick handler and in the timer thread
+ *  - Periodic events cannot be removed, so this runs last and the handlers stop measuring after BENCH_RELEASES
+ */
+static void RunPeriodic(void)
+{
+    StatsReset(&ShortStats);
+    StatsReset(&DeferredStats);
+
+    G8RTOS_AddPeriodicEvent(&ShortHandler, BENCH_PERIOD, PERIODIC_COALESCE, PERIODIC_SHORT);
+    G8RTOS_AddPeriodicEvent(&DeferredHandler, BENCH_PERIOD, PERIODIC_COALESCE, PERIODIC_DEFERRED);
+
+    while(ShortStats.samples < BENCH_RELEASES || DeferredStats.samples < BENCH_RELEASES)
+    {
+        G8RTOS_Sleep(BENCH_PERIOD * 10);
+    }
+}
+
+/*
+ * CPU load worker, keeps the CPU for LOAD_SPIN_MS then sleeps until it is killed
+ *  - Stays alive, a snapshot only has the threads that are
+ */
+static void LoadWorker(void)
+{
+    Spin((uint64_t)LOAD_SPIN_MS * ClockSys_GetSysFreq() / 1000);
+
+    while(1)
+    {
+        G8RTOS_Sleep(0x40000000);
+    }
+}
+
+/*
+ * Checks a CPU load window with a busy thread, the periodic events of RunPeriodic and the tick in it
+ *  - Every cycle of the window is charged somewhere, so the loads add up to 100%
+ *  - The tick is charged to ISR time, so its share is not 0
+ */
+static void RunCpuLoad(void)
+{
+    char row[128];
+
+    //Starts the window
+    G8RTOS_GetCpuLoad(&CpuLoad);
+
+    threadId_t worker = G8RTOS_AddThread(&LoadWorker, WORKER_PRIORITY, WORKER_STACKSIZE);
+    G8RTOS_Sleep(2 * LOAD_SPIN_MS);
+
+    int32_t status = G8RTOS_GetCpuLoad(&CpuLoad);
+    G8RTOS_KillThread(worker);
+    if(status == ERROR)
+    {
+        uartTransmitString("cpu_load,-,1,,,,fail: no window\n\r");
+        return;
+    }
+
+    uint32_t total = CpuLoad.periodicLoad + CpuLoad.isrLoad;
+    for(uint32_t i = 0; i < CpuLoad.numberOfThreads; i++)
+    {
+        total += CpuLoad.threads[i].load;
+    }
+
+    snprintf(row, sizeof(row), "cpu_load,total,1,,%lu,,0.01%%\n\r", (unsigned long)total);
+    uartTransmitString(row);
+    snprintf(row, sizeof(row), "cpu_load,isr,1,,%lu,,0.01%%\n\r", (unsigned long)CpuLoad.isrLoad);
+    uartTransmitString(row);
+
+    if(total + LOAD_TOLERANCE < 10000 || total > 10000 + LOAD_TOLERANCE || CpuLoad.isrLoad == 0)
+    {
+        uartTransmitString("cpu_load,-,1,,,,fail: loads do not add up to 100% or no ISR time\n\r");
+    }
+}
+
+/*
+ * Runs every benchmark once and prints its rows
+ */
+static void BenchmarkRunner(void)
+{
+    static const uint32_t sleepers[] = { 1, 6, BENCH_SLEEPERS };
+    static const uint32_t depths[] = { 1, 4, BENCH_FIFO_DEPTH };
+    static const uint32_t subscribers[] = { 1, 4, BENCH_SUBSCRIBERS };
+    static const uint32_t batches[] = { 1, 4, BENCH_FIFO_DEPTH };
+    static const uint32_t stress[][2] = { { 1, 1 }, { 4, 1 }, { 1, 4 }, { BENCH_STRESS_THREADS, BENCH_STRESS_THREADS } };
+    char parameter[24];
+
+    CyclesPerTick = ClockSys_GetSysFreq() / G8RTOS_TICK_HZ;
+
+    uartTransmitString("benchmark,parameter,samples,min,mean,max,unit\n\r");
+
+#ifndef G8RTOS_HOST
+    //Host switch is a swapcontext that stacks no FPU state, so only the board measures the PendSV paths
+    RunContextSwitch(false);
+    PrintRow("context_switch", "int", &Stats);
+    RunContextSwitch(true);
+    PrintRow("context_switch", "fpu", &Stats);
+#endif
+
+    //Scheduler and tick cost as sleeping threads are added
+    for(uint32_t i = 0; i < sizeof(sleepers) / sizeof(sleepers[0]); i++)
+    {
+        if(!Park(sleepers[i]))
+        {
+            break;
+        }
+        snprintf(parameter, sizeof(parameter), "sleepers=%lu", (unsigned long)sleepers[i]);
+
+        RunContextSwitch(false);
+        PrintRow("scheduler_switch", parameter, &Stats);
+        RunTickHandler();
+        PrintRow("tick_isr", parameter, &Stats);
+    }
+    Unpark();
+
+    RunSemaphore();
+    PrintRow("semaphore_round_trip", "-", &Stats);
+
+    for(uint32_t i = 0; i < sizeof(depths) / sizeof(depths[0]); i++)
+    {
+        RunFifo(depths[i], FIFO_MPMC);
+    }
+    for(uint32_t i = 0; i < sizeof(depths) / sizeof(depths[0]); i++)
+    {
+        RunFifo(depths[i], FIFO_SPSC);
+    }
+    RunFifoWrite(FIFO_MPMC);
+    PrintRow("fifo_write", "mpmc", &Stats);
+    RunFifoWrite(FIFO_SPSC);
+    PrintRow("fifo_write", "spsc", &Stats);
+    //Reader behind one that leaves without being woken
+    RunFifoHandoff(false);
+    RunFifoHandoff(true);
+    RunPool();
+    PrintRow("pool_buffer", "-", &Stats);
+
+    //Publishing wakes every blocked subscriber
+    for(uint32_t i = 0; i < sizeof(subscribers) / sizeof(subscribers[0]); i++)
+    {
+        RunTopic(subscribers[i]);
+        snprintf(parameter, sizeof(parameter), "subscribers=%lu", (unsigned long)subscribers[i]);
+        PrintRow("topic_publish", parameter, &Stats);
+    }
+
+    //Producers and consumers on one FIFO that blocks writers while it is full
+    for(uint32_t i = 0; i < sizeof(stress) / sizeof(stress[0]); i++)
+    {
+        RunFifoStress(stress[i][0], stress[i][1]);
+    }
+
+    //Same messages moved a batch at a time
+    for(uint32_t i = 0; i < sizeof(batches) / sizeof(batches[0]); i++)
+    {
+        RunFifoBatch(batches[i]);
+    }
+
+    RunInversion(false, MUTEX_NO_CEILING);
+    PrintRow("bus_blocking", "semaphore", &Stats);
+    RunInversion(true, MUTEX_NO_CEILING);
+    PrintRow("bus_blocking", "inheritance", &Stats);
+    RunInversion(true, WORKER_PRIORITY);
+    PrintRow("bus_blocking", "ceiling", &Stats);
+
+    RunSleep(1, false);
+    PrintRow("sleep_wakeup_late", "1ms", &Stats);
+    RunSleep(10, false);
+    PrintRow("sleep_wakeup_late", "10ms", &Stats);
+    RunSleep(1, true);
+    PrintRow("wait_timeout_late", "1ms", &Stats);
+    RunSleep(10, true);
+    PrintRow("wait_timeout_late", "10ms", &Stats);
+
+    RunPeriodic();
+    PrintRow("periodic_release_late", "short", &ShortStats);
+    PrintRow("periodic_release_late", "deferred", &DeferredStats);
+
+    //Periodic events keep running from here on
+    RunCpuLoad();
+
+#ifdef G8RTOS_HOST
+    exit(EXIT_SUCCESS);
+#endif
+}
+
+/*********************************************** Private Functions ********************************************************************/
+
+
+void main(void)
+{
+    //Initialize G8RTOS
+    G8RTOS_Init();
+
+    //Initializes UART
+    uartInit();
+
+    while(!(G8RTOS_AddThread(&BenchmarkRunner, RUNNER_PRIORITY, RUNNER_STACKSIZE) + 1));
+
+    //Start GatorOS
+    G8RTOS_Launch();
+}
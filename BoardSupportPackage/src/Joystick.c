@@ -104,11 +104,16 @@ void GetJoystickCoordinates(int16_t *x_coord, int16_t *y_coord)
     *y_coord = ADC14->MEM[Y_COORD_ADC_PIN] - 0x1FFF;
 }
 
+//Charges its time to ISR time once enabled, needs G8RTOS_Scheduler.h
 //__interrupt void PORT4_IRQHandler (void)
 //{
+//    void *previous = G8RTOS_EnterISR();
+//
 //    ButtonFunction();
 //
 //    P4->IFG &= ~BIT3;       // P4.3 IFG cleared
+//
+//    G8RTOS_ExitISR(previous);
 //}
 
 /*********************************************** Public Functions *********************************************************************/
@@ -36,6 +36,7 @@
 #include "msp432.h"
 #include "i2c_driver.h"
 #include "driverlib.h"
+#include "G8RTOS_Scheduler.h"
 
 //*****************************************************************************
 //
@@ -354,6 +355,9 @@ void EUSCIB1_IRQHandler(void)
 {
     uint_fast16_t status;
 
+    /* Time spent here is ISR time, not the interrupted thread's */
+    void *previous = G8RTOS_EnterISR();
+
     status = MAP_I2C_getEnabledInterruptStatus(EUSCI_B1_BASE);
     MAP_I2C_clearInterruptFlag(EUSCI_B1_BASE, status);
 
@@ -409,5 +413,7 @@ void EUSCIB1_IRQHandler(void)
 #ifdef USE_LPM
     MAP_Interrupt_disableSleepOnIsrExit();
 #endif
+
+    G8RTOS_ExitISR(previous);
 }
 
@@ -7,9 +7,15 @@
 
 #include <stdint.h>
 #include "G8RTOS_Semaphores.h"
+#include "G8RTOS_Mutex.h"
+#include "G8RTOS_EventFlags.h"
 #include "G8RTOS_Scheduler.h"
 #include "G8RTOS_Structures.h"
 #include "G8RTOS_IPC.h"
+#include "G8RTOS_Pool.h"
+#include "G8RTOS_Topic.h"
 #include "G8RTOS_CriticalSection.h"
+#include "G8RTOS_Time.h"
+#include "G8RTOS_Trace.h"
 
 #endif /* G8RTOS_H_ */
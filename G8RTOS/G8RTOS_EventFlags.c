@@ -0,0 +1,238 @@
+/*
+ * G8RTOS_EventFlags.c
+ */
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+#include <stdint.h>
+#include "msp.h"
+#include "BSP.h"
+#include "G8RTOS_EventFlags.h"
+#include "G8RTOS_CriticalSection.h"
+#include "G8RTOS_Scheduler.h"
+#include "G8RTOS.h"
+#include "G8RTOS_Trace.h"
+#include "G8RTOS_Port.h"
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+
+/*********************************************** Private Functions ********************************************************************/
+
+/*
+ * Checks whether flags satisfy a wait
+ * Param "flags": flags that are set
+ * Param "mask", "options": what is waited for
+ * Returns: flags of the mask that end the wait, 0 if it goes on
+ */
+static uint32_t Matched(uint32_t flags, uint32_t mask, uint8_t options)
+{
+    uint32_t matched = flags & mask;
+
+    if((options & EVENT_FLAGS_ALL) && matched != mask)
+    {
+        return 0;
+    }
+    return matched;
+}
+
+/*********************************************** Private Functions ********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Initializes an event flag group with every flag cleared
+ * Param "e": Pointer to event flag group
+ * THIS IS A CRITICAL SECTION
+ */
+void G8RTOS_InitEventFlags(eventFlags_t *e)
+{
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    e->flags = 0;
+    e->clearing = 0;
+    e->sets = 0;
+    G8RTOS_InitSemaphore(&e->waiters, 0, SEMAPHORE_FIFO);
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+}
+
+/*
+ * Sets flags, may be called from an interrupt
+ *  - Wakes every waiter the flags now satisfy, one check per critical section with interrupts enabled in between
+ *  - Flags a woken waiter asked to clear are cleared once every waiter has been checked
+ * Param "e": Pointer to event flag group
+ * Param "flags": Flags to set
+ * THIS IS A CRITICAL SECTION
+ */
+void G8RTOS_SetEventFlags(eventFlags_t *e, uint32_t flags)
+{
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    G8RTOS_TRACE(TRACE_FLAGS_SET, e);
+
+    //Flags set again stay set, even if a set still going on was going to clear them
+    e->flags |= flags;
+    e->clearing &= ~flags;
+    uint32_t set = ++e->sets;
+    int32_t waiting = -e->waiters.count;
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+
+    //Checks the waiter at the front of the queue one at a time, one that stays goes to the back
+    // - Queue is circular and in arrival order, so the ones not checked yet are always at the front
+    // - Stops at one that blocked after the flags were set, it has seen them already
+    // - Never more checks than were waiting, so waiters that time out meanwhile cannot keep it going
+    uint32_t cleared = 0;
+    while(waiting-- > 0)
+    {
+        //Disables interrupts
+        priMask = StartCriticalSection();
+
+        tcb_t *thread = e->waiters.waiters;
+        if(thread == 0 || (int32_t)(thread->eventSet - set) >= 0)
+        {
+            EndCriticalSection(priMask);
+            break;
+        }
+
+        //Checked against every flag still set, so one that clears them does not hide them from the ones behind it
+        uint32_t matched = Matched(e->flags, thread->eventMask, thread->eventOptions);
+        if(matched)
+        {
+            //Waiter learns what woke it through its mask
+            thread->eventMask = matched;
+            if(thread->eventOptions & EVENT_FLAGS_CLEAR)
+            {
+                cleared |= matched;
+                e->clearing |= matched;
+            }
+
+            e->waiters.count++;
+            G8RTOS_UnblockWaiter(thread);
+        }
+        else
+        {
+            e->waiters.waiters = thread->next;
+        }
+
+        //Enables interrupts
+        EndCriticalSection(priMask);
+    }
+
+    if(cleared)
+    {
+        //Disables interrupts
+        priMask = StartCriticalSection();
+
+        e->flags &= ~(cleared & e->clearing);
+        e->clearing &= ~cleared;
+
+        //Enables interrupts
+        EndCriticalSection(priMask);
+    }
+}
+
+/*
+ * Clears flags, may be called from an interrupt
+ * Param "e": Pointer to event flag group
+ * Param "flags": Flags to clear
+ * THIS IS A CRITICAL SECTION
+ */
+void G8RTOS_ClearEventFlags(eventFlags_t *e, uint32_t flags)
+{
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    e->flags &= ~flags;
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+}
+
+/*
+ * Returns: Flags that are set, not counting ones a set is about to clear
+ * Param "e": Pointer to event flag group
+ */
+uint32_t G8RTOS_GetEventFlags(eventFlags_t *e)
+{
+    return e->flags & ~e->clearing;
+}
+
+/*
+ * Waits until any or all of the flags in a mask are set
+ *  - A timeout of 0 never blocks, WAIT_FOREVER never times out
+ * Param "e": Pointer to event flag group
+ * Param "mask": Flags to wait for, not 0
+ * Param "options": EVENT_FLAGS_ANY or EVENT_FLAGS_ALL, with EVENT_FLAGS_CLEAR
+ * Param "timeoutMS": Longest time to wait in ms, rounded up to whole ticks like G8RTOS_Sleep
+ * Param "flags": Where the flags of the mask that ended the wait are stored, may be 0
+ * Returns: SUCCESS, or ERROR if the mask is 0 or the timeout ran out first
+ * THIS IS A CRITICAL SECTION
+ */
+int32_t G8RTOS_WaitEventFlags(eventFlags_t *e, uint32_t mask, uint8_t options, uint32_t timeoutMS, uint32_t *flags)
+{
+    if(mask == 0)
+    {
+        return ERROR;
+    }
+
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    tcb_t *thread = CurrentlyRunningThread;
+    uint32_t matched = Matched(e->flags & ~e->clearing, mask, options);
+
+    //Already satisfied, so no wait at all
+    if(matched)
+    {
+        if(options & EVENT_FLAGS_CLEAR)
+        {
+            e->flags &= ~matched;
+        }
+        EndCriticalSection(priMask);
+
+        if(flags != 0)
+        {
+            *flags = matched;
+        }
+        return SUCCESS;
+    }
+
+    if(timeoutMS == 0)
+    {
+        EndCriticalSection(priMask);
+        return ERROR;
+    }
+
+    //Blocks until a set satisfies the mask, the setter checks it against eventMask and eventOptions
+    G8RTOS_TRACE(TRACE_FLAGS_BLOCK, e);
+    thread->eventMask = mask;
+    thread->eventOptions = options;
+    thread->eventSet = e->sets;
+    e->waiters.count--;
+    G8RTOS_BlockThread(&e->waiters, (timeoutMS == WAIT_FOREVER) ? WAIT_FOREVER : G8RTOS_MsToTicks(timeoutMS));
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+
+    //Sets PendSV flag, to yield CPU, the thread runs again once woken or timed out
+    G8RTOS_PendSV();
+
+    if(thread->timedOut)
+    {
+        return ERROR;
+    }
+    if(flags != 0)
+    {
+        *flags = thread->eventMask;
+    }
+    return SUCCESS;
+}
+
+/*********************************************** Public Functions *********************************************************************/
@@ -0,0 +1,87 @@
+/*
+ * G8RTOS_EventFlags.h
+ *
+ * Event flag groups, 32 flags a thread can wait on any or all of
+ *  - Flags are set and cleared from threads or interrupts
+ *  - Setting flags wakes every waiter they satisfy, not just the first one
+ *  - Waiters are linked through their thread control blocks, like the waiters of a semaphore
+ */
+
+#ifndef G8RTOS_EVENTFLAGS_H_
+#define G8RTOS_EVENTFLAGS_H_
+
+#include <stdint.h>
+#include "G8RTOS_Semaphores.h"
+
+/*********************************************** Defines ******************************************************************************/
+
+/* Options of a wait, OR them together */
+#define EVENT_FLAGS_ANY 0x00 //Wait ends when any flag in the mask is set
+#define EVENT_FLAGS_ALL 0x01 //Wait ends when every flag in the mask is set
+#define EVENT_FLAGS_CLEAR 0x02 //Flags that end the wait are cleared, once the set has woken every waiter they satisfy
+
+/*********************************************** Defines ******************************************************************************/
+
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+/*
+ * Event flag group typedef
+ */
+typedef struct eventFlags_t
+{
+    uint32_t flags; //Flags that are set
+    uint32_t clearing; //Flags a set is waking waiters with that will be cleared once it is done, a new wait does not see them
+    uint32_t sets; //Sets so far
+    semaphore_t waiters; //Threads blocked on the group, its count is minus the number of them
+}eventFlags_t;
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Initializes an event flag group with every flag cleared
+ * Param "e": Pointer to event flag group
+ */
+void G8RTOS_InitEventFlags(eventFlags_t *e);
+
+/*
+ * Sets flags, may be called from an interrupt
+ *  - Wakes every waiter the flags now satisfy, one check per critical section with interrupts enabled in between
+ *  - Flags a woken waiter asked to clear are cleared once every waiter has been checked
+ * Param "e": Pointer to event flag group
+ * Param "flags": Flags to set
+ */
+void G8RTOS_SetEventFlags(eventFlags_t *e, uint32_t flags);
+
+/*
+ * Clears flags, may be called from an interrupt
+ * Param "e": Pointer to event flag group
+ * Param "flags": Flags to clear
+ */
+void G8RTOS_ClearEventFlags(eventFlags_t *e, uint32_t flags);
+
+/*
+ * Returns: Flags that are set, not counting ones a set is about to clear
+ * Param "e": Pointer to event flag group
+ */
+uint32_t G8RTOS_GetEventFlags(eventFlags_t *e);
+
+/*
+ * Waits until any or all of the flags in a mask are set
+ *  - A timeout of 0 never blocks, WAIT_FOREVER never times out
+ *  - Must not be called inside a critical section or from an interrupt
+ * Param "e": Pointer to event flag group
+ * Param "mask": Flags to wait for, not 0
+ * Param "options": EVENT_FLAGS_ANY or EVENT_FLAGS_ALL, with EVENT_FLAGS_CLEAR
+ * Param "timeoutMS": Longest time to wait in ms, rounded up to whole ticks like G8RTOS_Sleep
+ * Param "flags": Where the flags of the mask that ended the wait are stored, may be 0
+ * Returns: SUCCESS, or ERROR if the mask is 0 or the timeout ran out first
+ */
+int32_t G8RTOS_WaitEventFlags(eventFlags_t *e, uint32_t mask, uint8_t options, uint32_t timeoutMS, uint32_t *flags);
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif /* G8RTOS_EVENTFLAGS_H_ */
@@ -5,10 +5,16 @@
  *      Author: Daniel Gonzalez
  */
 #include <stdint.h>
+#include <string.h>
 #include "msp.h"
 #include "BSP.h"
 #include "G8RTOS_IPC.h"
 #include "G8RTOS_Semaphores.h"
+#include "G8RTOS_CriticalSection.h"
+#include "G8RTOS_Scheduler.h"
+#include "G8RTOS.h"
+#include "G8RTOS_Trace.h"
+#include "G8RTOS_Port.h"
 
 /*********************************************** Defines ******************************************************************************/
 
@@ -19,120 +25,675 @@
 
 /*********************************************** Data Structures Used *****************************************************************/
 
+/*
+ * Indices count up forever and are masked into the buffer, so the number of elements in it is writeIndex - readIndex
+ */
 typedef struct FIFO_t
 {
-    int32_t buffer[FIFOSIZE];
-    int32_t *head; //Pointer to the head of the FIFO, oldest spot
-    int32_t *tail; //Pointer to the tail of the FIFO, next empty spot
+    uint8_t *buffer; //Caller's storage, 0 while the FIFO is not in use
+    uint32_t mask; //Depth - 1, the depth is a power of two
+    uint32_t elementSize; //Bytes in one element
+    volatile uint32_t writeIndex; //Elements written so far, FIFO_SPSC: only the writer changes it
+    volatile uint32_t readIndex; //Elements read so far, FIFO_SPSC: only the reader changes it
     uint32_t lostData; //Amount of lost data
-    semaphore_t currentSize; //Semaphore to act as indicator for size
-    semaphore_t mutex; //Semaphore to indicate if FIFO is in use
+    semaphore_t notEmpty; //Readers waiting for data, FIFO_SPSC signals it through the doorbell instead
+    semaphore_t notFull; //Writers waiting for room, FIFO_BLOCK only
+    fifoMode_t mode; //How readers and writers share the FIFO
+    fifoFull_t full; //What a write to a full FIFO does
+
+    /* FIFO_SPSC only */
+    volatile uint32_t readerWants; //Elements the reader is blocked for, 0 while it is not, so the writer rings the doorbell
+    int32_t doorbell; //Signals notEmpty for the writer
 
 }FIFO_t;
 
 /* Array of FIFOS */
-static FIFO_t FIFOs[4];
+static FIFO_t FIFOs[MAX_NUMBER_OF_FIFOS];
 
 /*********************************************** Data Structures Used *****************************************************************/
 
+
+/*********************************************** Private Functions ********************************************************************/
+
+/*
+ * Copies one element, sizes of a word or less without a call, as a constant size memcpy is a single load and store
+ * Param "to", "from": where the element goes and where it is
+ * Param "size": bytes in the element
+ */
+static inline void CopyElement(void *to, const void *from, uint32_t size)
+{
+    switch(size)
+    {
+    case 1:
+        memcpy(to, from, 1);
+        break;
+    case 2:
+        memcpy(to, from, 2);
+        break;
+    case 4:
+        memcpy(to, from, 4);
+        break;
+    default:
+        memcpy(to, from, size);
+        break;
+    }
+}
+
+/*
+ * Returns: place in the buffer of an element
+ * Param "FIFO": FIFO the element is in
+ * Param "index": read or write index of the element
+ */
+static inline uint8_t *Element(FIFO_t *FIFO, uint32_t index)
+{
+    return FIFO->buffer + (index & FIFO->mask) * FIFO->elementSize;
+}
+
+/*
+ * Copies elements into a FIFO's buffer, in two pieces if they wrap around its end
+ * Param "FIFO": FIFO to copy into
+ * Param "index": write index of the first element
+ * Param "data": elements to copy
+ * Param "count": elements to copy, at most the depth
+ */
+static void CopyIn(FIFO_t *FIFO, uint32_t index, const uint8_t *data, uint32_t count)
+{
+    //Single elements skip the wrap math
+    if(count == 1)
+    {
+        CopyElement(Element(FIFO, index), data, FIFO->elementSize);
+        return;
+    }
+
+    //Elements up to the end of the buffer, then the rest from its start
+    uint32_t first = FIFO->mask + 1 - (index & FIFO->mask);
+    if(first > count)
+    {
+        first = count;
+    }
+    memcpy(Element(FIFO, index), data, first * FIFO->elementSize);
+    memcpy(FIFO->buffer, data + first * FIFO->elementSize, (count - first) * FIFO->elementSize);
+}
+
+/*
+ * Copies elements out of a FIFO's buffer, in two pieces if they wrap around its end
+ * Param "FIFO": FIFO to copy from
+ * Param "index": read index of the first element
+ * Param "data": where the elements go
+ * Param "count": elements to copy, at most the depth
+ */
+static void CopyOut(FIFO_t *FIFO, uint32_t index, uint8_t *data, uint32_t count)
+{
+    //Single elements skip the wrap math
+    if(count == 1)
+    {
+        CopyElement(data, Element(FIFO, index), FIFO->elementSize);
+        return;
+    }
+
+    //Elements up to the end of the buffer, then the rest from its start
+    uint32_t first = FIFO->mask + 1 - (index & FIFO->mask);
+    if(first > count)
+    {
+        first = count;
+    }
+    memcpy(data, Element(FIFO, index), first * FIFO->elementSize);
+    memcpy(data + first * FIFO->elementSize, FIFO->buffer, (count - first) * FIFO->elementSize);
+}
+
+/*
+ * Wakes threads waiting on a wait queue of a FIFO, in queue order, while there is enough for the first one
+ *  - Must be called with interrupts disabled
+ *  - A waiter that needs more than is left stops the wakeups, so a big batch is not passed over by small ones
+ *  - Woken threads check the FIFO again, another one may have got there first
+ * Param "queue": notEmpty or notFull
+ * Param "available": elements for readers or free places for writers
+ */
+static void Wake(semaphore_t *queue, uint32_t available)
+{
+    while(queue->count < 0 && queue->waiters->waitCount <= available)
+    {
+        available -= queue->waiters->waitCount;
+        queue->count++;
+        G8RTOS_UnblockThread(queue);
+    }
+}
+
+/*
+ * Blocks the running thread on a wait queue of a FIFO until another thread wakes it or the deadline passes
+ *  - Must be called with interrupts disabled, they are enabled again when it returns
+ * Param "queue": notEmpty or notFull
+ * Param "wanted": elements or free places the thread needs before it is woken
+ * Param "timeoutMS": timeout the wait started with, 0 never blocks, or WAIT_FOREVER
+ * Param "deadline": tick the wait ends at, unless timeoutMS is WAIT_FOREVER
+ * Param "priMask": interrupt state to go back to
+ * Returns: SUCCESS once woken, or ERROR if the deadline passed
+ */
+static int WaitOn(semaphore_t *queue, uint32_t wanted, uint32_t timeoutMS, uint32_t deadline, int32_t priMask)
+{
+    uint32_t ticks = WAIT_FOREVER;
+
+    if(timeoutMS != WAIT_FOREVER)
+    {
+        //Time is left only while the deadline is still ahead
+        ticks = deadline - SystemTime;
+        if(timeoutMS == 0 || (int32_t)ticks <= 0)
+        {
+            EndCriticalSection(priMask);
+            return ERROR;
+        }
+    }
+
+    G8RTOS_TRACE(TRACE_SEM_BLOCK, queue);
+    CurrentlyRunningThread->waitCount = wanted;
+    queue->count--;
+    G8RTOS_BlockThread(queue, ticks);
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+
+    //Sets PendSV flag, to yield CPU, the thread runs again once woken or timed out
+    G8RTOS_PendSV();
+
+    return CurrentlyRunningThread->timedOut ? ERROR : SUCCESS;
+}
+
 /*
- * Initializes FIFO Struct
+ * Reads a FIFO_SPSC FIFO, only ever called by its one reader
+ *  - Takes what is there, then blocks on notEmpty after telling the writer how much more it needs,
+ *    the writer rings the doorbell once that much is there
+ *  - A doorbell can be left over from data that was read without blocking, so the FIFO is checked again after every wakeup
+ * Param "FIFO": chooses which buffer we want to read from
+ * Param "data": where the elements read are stored
+ * Param "minimum", "maximum": elements to wait for and most elements to read
+ * Param "timeoutMS": longest time to wait in ms for each wakeup, 0 never blocks, or WAIT_FOREVER
+ * Returns: elements read, fewer than minimum if the wait timed out
  */
-int G8RTOS_InitFIFO(uint32_t FIFOIndex)
+static int32_t ReadSPSC(FIFO_t *FIFO, uint8_t *data, uint32_t minimum, uint32_t maximum, uint32_t timeoutMS)
 {
-    if(FIFOIndex < MAX_NUMBER_OF_FIFOS){
-        FIFOs[FIFOIndex].head = &FIFOs[FIFOIndex].buffer[0];
-        FIFOs[FIFOIndex].tail = &FIFOs[FIFOIndex].buffer[0];
-        FIFOs[FIFOIndex].lostData = 0;
-        G8RTOS_InitSemaphore(&FIFOs[FIFOIndex].currentSize, 0);
-        G8RTOS_InitSemaphore(&FIFOs[FIFOIndex].mutex, 1);
+    uint32_t got = 0;
+
+    while(1)
+    {
+        uint32_t read = FIFO->readIndex;
+        uint32_t count = FIFO->writeIndex - read;
+        if(count > maximum - got)
+        {
+            count = maximum - got;
+        }
+
+        if(count != 0)
+        {
+            //Data is read only after the index that published it
+            __DMB();
+            CopyOut(FIFO, read, data + got * FIFO->elementSize, count);
+            G8RTOS_TRACE(TRACE_FIFO_READ, FIFO);
+
+            //Places are given back to the writer only once the data is out of them
+            __DMB();
+            FIFO->readIndex = read + count;
+            got += count;
+        }
+
+        if(got >= minimum || timeoutMS == 0)
+        {
+            return got;
+        }
 
-        return SUCCESS;
+        //Writer checks what the reader wants after publishing its index, so one of the two sees the other
+        FIFO->readerWants = minimum - got;
+        __DMB();
+
+        //Data written before the flag was seen rang no doorbell, so it is not waited for
+        int status = SUCCESS;
+        if(FIFO->writeIndex - FIFO->readIndex < minimum - got)
+        {
+            status = G8RTOS_WaitSemaphoreTimeout(&FIFO->notEmpty, timeoutMS);
+        }
+        FIFO->readerWants = 0;
+
+        if(status == ERROR)
+        {
+            return got;
+        }
     }
-    return ERROR;
+}
+
+/*
+ * Writes a FIFO_SPSC FIFO, only ever called by its one writer, which may be an interrupt
+ *  - Never disables interrupts, blocks or touches a semaphore
+ *  - Elements that do not fit are lost
+ * Param "FIFO": chooses which buffer we want to write to
+ * Param "data": elements being put into FIFO
+ * Param "count": elements to write
+ * Returns: elements written
+ */
+static int32_t WriteSPSC(FIFO_t *FIFO, const uint8_t *data, uint32_t count)
+{
+    uint32_t write = FIFO->writeIndex;
+    uint32_t room = FIFO->mask + 1 - (write - FIFO->readIndex);
+
+    //If FIFO is too full, then
+    if(count > room)
+    {
+        //Increments lost data because it will not be saved
+        FIFO->lostData += count - room;
+        G8RTOS_TRACE(TRACE_FIFO_DROP, FIFO);
+
+        count = room;
+        if(count == 0)
+        {
+            return 0;
+        }
+    }
+
+    //Data is in the buffer before the reader can see the new index
+    CopyIn(FIFO, write, data, count);
+    __DMB();
+    FIFO->writeIndex = write + count;
+    G8RTOS_TRACE(TRACE_FIFO_WRITE, FIFO);
+
+    //Reader checks the index again after saying what it wants, so one of the two sees the other
+    __DMB();
+    uint32_t wants = FIFO->readerWants;
+    if(wants != 0 && write + count - FIFO->readIndex >= wants)
+    {
+        G8RTOS_RingDoorbell(FIFO->doorbell);
+    }
+
+    return count;
+}
+
+/*********************************************** Private Functions ********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Creates a FIFO in storage given by the caller
+ * Param "buffer": storage for "depth" elements, used by the FIFO until it is deleted
+ * Param "depth": elements the FIFO holds, a power of two
+ * Param "elementSize": bytes in one element, sizeof its type
+ * Param "mode": FIFO_MPMC or FIFO_SPSC
+ * Param "full": what a write to a full FIFO does, FIFO_SPSC only drops the newest data
+ * Returns: handle of the FIFO, or 0 if an argument is wrong or MAX_NUMBER_OF_FIFOS or all doorbells are in use
+ * THIS IS A CRITICAL SECTION
+ */
+fifoHandle_t G8RTOS_CreateFIFO(void *buffer, uint32_t depth, uint32_t elementSize, fifoMode_t mode, fifoFull_t full)
+{
+    //Depth has to be a power of two for the indices to be masked
+    if(buffer == 0 || depth == 0 || (depth & (depth - 1)) != 0 || elementSize == 0 ||
+       (mode == FIFO_SPSC && full != FIFO_DROP_NEWEST))
+    {
+        return 0;
+    }
+
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    //Finds a FIFO not in use
+    FIFO_t *FIFO = 0;
+    for(uint32_t i = 0; i < MAX_NUMBER_OF_FIFOS; i++)
+    {
+        if(FIFOs[i].buffer == 0)
+        {
+            FIFO = &FIFOs[i];
+            break;
+        }
+    }
+
+    //Creating a FIFO in the same place again keeps the doorbell it already has
+    int32_t doorbell = 0;
+    if(FIFO != 0 && mode == FIFO_SPSC)
+    {
+        doorbell = G8RTOS_AddDoorbell(&FIFO->notEmpty);
+    }
+
+    if(FIFO == 0 || doorbell == ERROR)
+    {
+        EndCriticalSection(priMask);
+        return 0;
+    }
+
+    FIFO->buffer = buffer;
+    FIFO->mask = depth - 1;
+    FIFO->elementSize = elementSize;
+    FIFO->writeIndex = 0;
+    FIFO->readIndex = 0;
+    FIFO->lostData = 0;
+    G8RTOS_InitSemaphore(&FIFO->notEmpty, 0, SEMAPHORE_PRIORITY);
+    G8RTOS_InitSemaphore(&FIFO->notFull, 0, SEMAPHORE_PRIORITY);
+    FIFO->mode = mode;
+    FIFO->full = full;
+    FIFO->readerWants = 0;
+    FIFO->doorbell = doorbell;
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+    return FIFO;
+}
+
+/*
+ * Deletes a FIFO, so its handle is no longer used and its buffer goes back to the caller
+ * Param "FIFO": FIFO to delete
+ * Returns: SUCCESS, or ERROR if threads are still waiting on it
+ * THIS IS A CRITICAL SECTION
+ */
+int G8RTOS_DeleteFIFO(fifoHandle_t FIFO)
+{
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    if(FIFO->notEmpty.count < 0 || FIFO->notFull.count < 0)
+    {
+        EndCriticalSection(priMask);
+        return ERROR;
+    }
+    FIFO->buffer = 0;
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+    return SUCCESS;
+}
+
+/*
+ * Returns: Elements lost because the FIFO was full or a write timed out
+ * Param "FIFO": FIFO to check
+ */
+uint32_t G8RTOS_GetLostData(fifoHandle_t FIFO)
+{
+    return FIFO->lostData;
 }
 
 /*
  * Reads FIFO
- *  - Waits until CurrentSize semaphore is greater than zero
- *  - Gets data and increments the head ptr (wraps if necessary)
- * Param: "FIFOChoice": chooses which buffer we want to read from
- * Returns: uint32_t Data from FIFO
+ *  - Waits until the FIFO has data
+ *  - Copies out the oldest element and moves the head on
+ * Param "FIFO": chooses which buffer we want to read from
+ * Param "data": where the element read is stored
+ * Returns: SUCCESS
  */
-uint32_t readFIFO(uint32_t FIFOChoice)
+int readFIFO(fifoHandle_t FIFO, void *data)
 {
-    //Wait before reading FIFO in case of being read in another thread
-    G8RTOS_WaitSemaphore(&FIFOs[FIFOChoice].mutex);
+    return readFIFOTimeout(FIFO, data, WAIT_FOREVER);
+}
 
-    //Wait before reading FIFO in case of empty FIFO
-    G8RTOS_WaitSemaphore(&FIFOs[FIFOChoice].currentSize);
+/*
+ * Reads FIFO, giving up if no data comes in time
+ *  - A timeout of 0 never blocks
+ *  - FIFO_SPSC waits at most timeoutMS for each wakeup
+ * Param "FIFO": chooses which buffer we want to read from
+ * Param "data": where the element read is stored
+ * Param "timeoutMS": longest time to wait in ms, or WAIT_FOREVER
+ * Returns: SUCCESS, or ERROR if the wait timed out and nothing was read
+ */
+int readFIFOTimeout(fifoHandle_t FIFO, void *data, uint32_t timeoutMS)
+{
+    return (readFIFOBlock(FIFO, data, 1, 1, timeoutMS) == 1) ? SUCCESS : ERROR;
+}
 
-    //Read Thread
-    uint32_t data = *(FIFOs[FIFOChoice].head);
+/*
+ * Reads FIFO only if it has data, never blocks
+ * Param "FIFO": chooses which buffer we want to read from
+ * Param "data": where the element read is stored
+ * Returns: SUCCESS, or ERROR if nothing was read
+ */
+int tryReadFIFO(fifoHandle_t FIFO, void *data)
+{
+    return readFIFOTimeout(FIFO, data, 0);
+}
+
+/*
+ * Reads a batch of elements from FIFO
+ *  - Takes whatever is there up to maximum, and waits for more only while it has fewer than minimum
+ *  - Each pass moves every element it can with one critical section and one index update
+ *  - A reader waiting for a batch is woken once the whole rest of it is there, readers behind it wait their turn
+ *  - A timeout of 0 never blocks, FIFO_SPSC waits at most timeoutMS for each wakeup
+ * Param "FIFO": chooses which buffer we want to read from
+ * Param "data": where the elements read are stored, room for maximum of them
+ * Param "minimum": elements to wait for, at most the depth, 0 only takes what is there
+ * Param "maximum": most elements to read
+ * Param "timeoutMS": longest time to wait in ms, or WAIT_FOREVER
+ * Returns: elements read, fewer than minimum if the wait timed out, or ERROR if minimum is wrong
+ * THIS IS A CRITICAL SECTION
+ */
+int32_t readFIFOBlock(fifoHandle_t FIFO, void *data, uint32_t minimum, uint32_t maximum, uint32_t timeoutMS)
+{
+    if(minimum > maximum || minimum > FIFO->mask + 1)
+    {
+        return ERROR;
+    }
 
-    //If head is at last index in array, then
-    if(FIFOs[FIFOChoice].head == &FIFOs[FIFOChoice].buffer[FIFOSIZE - 1])
+    if(FIFO->mode == FIFO_SPSC)
     {
-        //Moves head to beginning
-        FIFOs[FIFOChoice].head = &FIFOs[FIFOChoice].buffer[0];
+        return ReadSPSC(FIFO, data, minimum, maximum, timeoutMS);
     }
-    else
+
+    uint32_t deadline = 0;
+    if(timeoutMS != WAIT_FOREVER)
     {
-        //Increment head pointer
-        FIFOs[FIFOChoice].head++;
+        deadline = SystemTime + G8RTOS_MsToTicks(timeoutMS);
     }
 
-    //Release semaphore to indicate its ready to use
-    G8RTOS_SignalSemaphore(&FIFOs[FIFOChoice].mutex);
+    uint8_t *out = data;
+    uint32_t got = 0;
 
-    return data;
+    while(1)
+    {
+        //Disables interrupts
+        int32_t priMask = StartCriticalSection();
+
+        uint32_t count = FIFO->writeIndex - FIFO->readIndex;
+        if(count > maximum - got)
+        {
+            count = maximum - got;
+        }
+
+        if(count != 0)
+        {
+            CopyOut(FIFO, FIFO->readIndex, out + got * FIFO->elementSize, count);
+            FIFO->readIndex += count;
+            got += count;
+            G8RTOS_TRACE(TRACE_FIFO_READ, FIFO);
+
+            //Room was made, so blocked writers can go on
+            Wake(&FIFO->notFull, FIFO->mask + 1 - (FIFO->writeIndex - FIFO->readIndex));
+        }
+
+        if(got >= minimum)
+        {
+            //Enables interrupts
+            EndCriticalSection(priMask);
+            return got;
+        }
+
+        //Waits for writers, without holding anything other readers or writers need
+        if(WaitOn(&FIFO->notEmpty, minimum - got, timeoutMS, deadline, priMask) == ERROR)
+        {
+            //Left the queue without being woken, so the readers behind get the wakeup it held back
+            priMask = StartCriticalSection();
+            Wake(&FIFO->notEmpty, FIFO->writeIndex - FIFO->readIndex);
+            EndCriticalSection(priMask);
+            return got;
+        }
+    }
 }
 
 /*
  * Writes to FIFO
- *  Writes data to Tail of the buffer if the buffer is not full
- *  Increments tail (wraps if ncessary)
- *  Param "FIFOChoice": chooses which buffer we want to read from
- *        "Data': Data being put into FIFO
+ *  Copies the element to the tail of the buffer, a full buffer is handled by the FIFO's fifoFull_t
+ *  Only writes that cannot block may come from an interrupt
+ *  Param "FIFO": chooses which buffer we want to write to
+ *        "data": element being put into FIFO
  *  Returns: error code for full buffer if unable to write
  */
-int writeFIFO(uint32_t FIFOChoice, uint32_t Data)
+int writeFIFO(fifoHandle_t FIFO, const void *data)
 {
-    //If FIFO is full, then
-    if(FIFOs[FIFOChoice].currentSize > FIFOSIZE - 1)
+    return writeFIFOTimeout(FIFO, data, WAIT_FOREVER);
+}
+
+/*
+ * Writes to FIFO, giving up if a FIFO_BLOCK FIFO stays full too long
+ *  Data is lost if the buffer is full and the FIFO does not block, or the timeout runs out
+ *  Overwriting the oldest data always succeeds, the overwritten data counts as lost
+ *  Param "FIFO": chooses which buffer we want to write to
+ *        "data": element being put into FIFO
+ *        "timeoutMS": longest time to wait for room in ms, 0 never blocks, or WAIT_FOREVER
+ *  Returns: error code if unable to write
+ */
+int writeFIFOTimeout(fifoHandle_t FIFO, const void *data, uint32_t timeoutMS)
+{
+    return (writeFIFOBlock(FIFO, data, 1, timeoutMS) == 1) ? SUCCESS : ERROR;
+}
+
+/*
+ * Writes to FIFO only if it has room, never blocks
+ *  Param "FIFO": chooses which buffer we want to write to
+ *        "data": element being put into FIFO
+ *  Returns: error code if unable to write
+ */
+int tryWriteFIFO(fifoHandle_t FIFO, const void *data)
+{
+    return writeFIFOTimeout(FIFO, data, 0);
+}
+
+/*
+ * Writes a batch of elements to FIFO
+ *  Each pass moves every element that fits with one critical section and one index update
+ *  FIFO_BLOCK waits until there is room for the rest, or as much of it as the FIFO holds
+ *  Elements that do not fit are handled by the FIFO's fifoFull_t and count as lost
+ *  Param "FIFO": chooses which buffer we want to write to
+ *        "data": elements being put into FIFO
+ *        "count": elements to write
+ *        "timeoutMS": longest time to wait for room in ms, 0 never blocks, or WAIT_FOREVER
+ *  Returns: elements written, all of them when overwriting the oldest data
+ *  THIS IS A CRITICAL SECTION
+ */
+int32_t writeFIFOBlock(fifoHandle_t FIFO, const void *data, uint32_t count, uint32_t timeoutMS)
+{
+    if(FIFO->mode == FIFO_SPSC)
     {
-        //Increments lost data because it will not be saved
-        FIFOs[FIFOChoice].lostData++;
+        return WriteSPSC(FIFO, data, count);
+    }
 
-        return ERROR;
+    uint32_t depth = FIFO->mask + 1;
+    const uint8_t *in = data;
+    uint32_t put = 0;
+
+    uint32_t deadline = 0;
+    if(FIFO->full == FIFO_BLOCK && timeoutMS != WAIT_FOREVER)
+    {
+        deadline = SystemTime + G8RTOS_MsToTicks(timeoutMS);
     }
-    else
+
+    //Only the newest elements that fit could be kept, so the older ones are lost without being copied
+    if(FIFO->full == FIFO_OVERWRITE_OLDEST && count > depth)
     {
-        //Wait before reading FIFO in case of being read in another thread
-        G8RTOS_WaitSemaphore(&FIFOs[FIFOChoice].mutex);
+        put = count - depth;
+
+        //Disables interrupts
+        int32_t priMask = StartCriticalSection();
+        FIFO->lostData += put;
+        EndCriticalSection(priMask);
+    }
+
+    while(1)
+    {
+        //Disables interrupts
+        int32_t priMask = StartCriticalSection();
+
+        uint32_t size = count - put;
+        uint32_t room = depth - (FIFO->writeIndex - FIFO->readIndex);
+
+        //Oldest data makes room for the newest
+        if(size > room && FIFO->full == FIFO_OVERWRITE_OLDEST)
+        {
+            FIFO->readIndex += size - room;
+            FIFO->lostData += size - room;
+            G8RTOS_TRACE(TRACE_FIFO_DROP, FIFO);
+            room = size;
+        }
+
+        if(size > room)
+        {
+            size = room;
+        }
 
-        //Writes data in FIFO
-        *(FIFOs[FIFOChoice].tail) = Data;
+        if(size != 0)
+        {
+            CopyIn(FIFO, FIFO->writeIndex, in + put * FIFO->elementSize, size);
+            FIFO->writeIndex += size;
+            put += size;
+            G8RTOS_TRACE(TRACE_FIFO_WRITE, FIFO);
+
+            //Wakes readers waiting for data
+            Wake(&FIFO->notEmpty, FIFO->writeIndex - FIFO->readIndex);
+        }
 
-        //If tail pointer is pointing to last index, then
-        if(FIFOs[FIFOChoice].tail == &FIFOs[FIFOChoice].buffer[FIFOSIZE-1])
+        if(put == count)
         {
-            //Moves head to beginning
-            FIFOs[FIFOChoice].tail = &FIFOs[FIFOChoice].buffer[0];
+            //Enables interrupts
+            EndCriticalSection(priMask);
+            return put;
         }
-        else
+
+        if(FIFO->full == FIFO_BLOCK)
         {
-            //Moves head to beginning
-            FIFOs[FIFOChoice].tail++;
+            //Waits for readers to make room for the rest
+            size = count - put;
+            if(WaitOn(&FIFO->notFull, (size < depth) ? size : depth, timeoutMS, deadline, priMask) == SUCCESS)
+            {
+                continue;
+            }
+            priMask = StartCriticalSection();
+
+            //Left the queue without being woken, so the writers behind get the wakeup it held back
+            Wake(&FIFO->notFull, depth - (FIFO->writeIndex - FIFO->readIndex));
         }
 
-        //Release semaphore to indicate its ready to use
-        G8RTOS_SignalSemaphore(&FIFOs[FIFOChoice].mutex);
+        //Increments lost data because it will not be saved
+        FIFO->lostData += count - put;
+        G8RTOS_TRACE(TRACE_FIFO_DROP, FIFO);
+
+        //Enables interrupts
+        EndCriticalSection(priMask);
+        return put;
     }
+}
 
-    //Signal current size semaphore
-    G8RTOS_SignalSemaphore(&FIFOs[FIFOChoice].currentSize);
+/*********************************************** Public Functions *********************************************************************/
 
-    return SUCCESS;
+
+/*********************************************** Kernel Functions *********************************************************************/
+
+/*
+ * Passes on the wakeups a thread held back at the front of a FIFO wait queue, for a thread taken out of one without being woken
+ *  - Must be called with interrupts disabled, after the thread is out of the queue and its count is given back
+ *  - Queues that are not a FIFO's are left alone
+ * Param "queue": wait queue the thread was blocked on
+ */
+void G8RTOS_AbandonFIFOWait(semaphore_t *queue)
+{
+    for(uint32_t i = 0; i < MAX_NUMBER_OF_FIFOS; i++)
+    {
+        FIFO_t *FIFO = &FIFOs[i];
+        uint32_t count = FIFO->writeIndex - FIFO->readIndex;
+
+        if(FIFO->buffer == 0)
+        {
+            continue;
+        }
+        if(queue == &FIFO->notEmpty && FIFO->mode == FIFO_MPMC)
+        {
+            Wake(queue, count);
+            return;
+        }
+        if(queue == &FIFO->notFull)
+        {
+            Wake(queue, FIFO->mask + 1 - count);
+            return;
+        }
+    }
 }
 
+/*********************************************** Kernel Functions *********************************************************************/
@@ -8,40 +8,177 @@
 #ifndef G8RTOS_G8RTOS_IPC_H_
 #define G8RTOS_G8RTOS_IPC_H_
 
-#define FIFOSIZE 16
+#include <stdint.h>
+#include "G8RTOS_Semaphores.h"
+
+/* FIFOs that can exist at once, their buffers are given by the caller */
+#ifndef MAX_NUMBER_OF_FIFOS
 #define MAX_NUMBER_OF_FIFOS 4
+#endif
 
 /*********************************************** Error Codes **************************************************************************/
 
 /*********************************************** Error Codes **************************************************************************/
 
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+/*
+ * How the readers and writers of a FIFO share it
+ */
+typedef enum
+{
+    FIFO_MPMC, //Any number of readers and writers, each read or write is a short critical section
+    FIFO_SPSC //One writer, which may be an interrupt, and one reader thread, no locks at all
+}fifoMode_t;
+
+/*
+ * What a write to a full FIFO does
+ */
+typedef enum
+{
+    FIFO_DROP_NEWEST, //Data written is lost
+    FIFO_OVERWRITE_OLDEST, //Data written replaces the oldest data, which is lost, FIFO_MPMC only
+    FIFO_BLOCK //Writer waits for a reader to make room, FIFO_MPMC only
+}fifoFull_t;
+
+/*
+ * FIFO handle, what the FIFO functions take
+ */
+typedef struct FIFO_t *fifoHandle_t;
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
 /*********************************************** Public Functions *********************************************************************/
 
 /*
- * Initializes One to One FIFO Struct
+ * Creates a FIFO in storage given by the caller
+ *  - Elements are copied in and out whole, so they can be any type, structs included
+ *  - FIFO_MPMC: readers wait for data and FIFO_BLOCK writers wait for room, each in a wait queue of its own
+ *  - FIFO_SPSC: the writer never disables interrupts, blocks or touches a semaphore,
+ *    so it may write from an interrupt, and the reader is woken through a doorbell
+ * Param "buffer": storage for "depth" elements, used by the FIFO until it is deleted
+ * Param "depth": elements the FIFO holds, a power of two
+ * Param "elementSize": bytes in one element, sizeof its type
+ * Param "mode": FIFO_MPMC or FIFO_SPSC
+ * Param "full": what a write to a full FIFO does, FIFO_SPSC only drops the newest data
+ * Returns: handle of the FIFO, or 0 if an argument is wrong or MAX_NUMBER_OF_FIFOS or all doorbells are in use
+ */
+fifoHandle_t G8RTOS_CreateFIFO(void *buffer, uint32_t depth, uint32_t elementSize, fifoMode_t mode, fifoFull_t full);
+
+/*
+ * Deletes a FIFO, so its handle is no longer used and its buffer goes back to the caller
+ * Param "FIFO": FIFO to delete
+ * Returns: SUCCESS, or ERROR if threads are still waiting on it
  */
-int G8RTOS_InitFIFO(uint32_t FIFOIndex);
+int G8RTOS_DeleteFIFO(fifoHandle_t FIFO);
+
+/*
+ * Returns: Elements lost because the FIFO was full or a write timed out
+ * Param "FIFO": FIFO to check
+ */
+uint32_t G8RTOS_GetLostData(fifoHandle_t FIFO);
 
 /*
  * Reads FIFO
- *  - Waits until CurrentSize semaphore is greater than zero
- *  - Gets data and increments the head ptr (wraps if necessary)
- * Param "FIFOChoice": chooses which buffer we want to read from
- * Returns: uint32_t Data from FIFO
+ *  - Waits until the FIFO has data
+ *  - Copies out the oldest element and moves the head on
+ * Param "FIFO": chooses which buffer we want to read from
+ * Param "data": where the element read is stored
+ * Returns: SUCCESS
+ */
+int readFIFO(fifoHandle_t FIFO, void *data);
+
+/*
+ * Reads FIFO, giving up if no data comes in time
+ *  - A timeout of 0 never blocks
+ *  - FIFO_SPSC waits at most timeoutMS for each wakeup
+ * Param "FIFO": chooses which buffer we want to read from
+ * Param "data": where the element read is stored
+ * Param "timeoutMS": longest time to wait in ms, or WAIT_FOREVER
+ * Returns: SUCCESS, or ERROR if the wait timed out and nothing was read
+ */
+int readFIFOTimeout(fifoHandle_t FIFO, void *data, uint32_t timeoutMS);
+
+/*
+ * Reads FIFO only if it has data, never blocks
+ * Param "FIFO": chooses which buffer we want to read from
+ * Param "data": where the element read is stored
+ * Returns: SUCCESS, or ERROR if nothing was read
  */
-uint32_t readFIFO(uint32_t FIFO);
+int tryReadFIFO(fifoHandle_t FIFO, void *data);
+
+/*
+ * Reads a batch of elements from FIFO
+ *  - Takes whatever is there up to maximum, and waits for more only while it has fewer than minimum
+ *  - Each pass moves every element it can with one critical section and one index update
+ *  - A reader waiting for a batch is woken once the whole rest of it is there, readers behind it wait their turn
+ *  - A timeout of 0 never blocks, FIFO_SPSC waits at most timeoutMS for each wakeup
+ * Param "FIFO": chooses which buffer we want to read from
+ * Param "data": where the elements read are stored, room for maximum of them
+ * Param "minimum": elements to wait for, at most the depth, 0 only takes what is there
+ * Param "maximum": most elements to read
+ * Param "timeoutMS": longest time to wait in ms, or WAIT_FOREVER
+ * Returns: elements read, fewer than minimum if the wait timed out, or ERROR if minimum is wrong
+ */
+int32_t readFIFOBlock(fifoHandle_t FIFO, void *data, uint32_t minimum, uint32_t maximum, uint32_t timeoutMS);
 
 /*
  * Writes to FIFO
- *  Writes data to Tail of the buffer if the buffer is not full
- *  Increments tail (wraps if ncessary)
- *  Param "FIFOChoice": chooses which buffer we want to read from
- *        "Data': Data being put into FIFO
+ *  Copies the element to the tail of the buffer, a full buffer is handled by the FIFO's fifoFull_t
+ *  Only writes that cannot block may come from an interrupt
+ *  Param "FIFO": chooses which buffer we want to write to
+ *        "data": element being put into FIFO
  *  Returns: error code for full buffer if unable to write
  */
-int writeFIFO(uint32_t FIFO, uint32_t data);
+int writeFIFO(fifoHandle_t FIFO, const void *data);
+
+/*
+ * Writes to FIFO, giving up if a FIFO_BLOCK FIFO stays full too long
+ *  Data is lost if the buffer is full and the FIFO does not block, or the timeout runs out
+ *  Overwriting the oldest data always succeeds, the overwritten data counts as lost
+ *  Param "FIFO": chooses which buffer we want to write to
+ *        "data": element being put into FIFO
+ *        "timeoutMS": longest time to wait for room in ms, 0 never blocks, or WAIT_FOREVER
+ *  Returns: error code if unable to write
+ */
+int writeFIFOTimeout(fifoHandle_t FIFO, const void *data, uint32_t timeoutMS);
+
+/*
+ * Writes to FIFO only if it has room, never blocks
+ *  Param "FIFO": chooses which buffer we want to write to
+ *        "data": element being put into FIFO
+ *  Returns: error code if unable to write
+ */
+int tryWriteFIFO(fifoHandle_t FIFO, const void *data);
+
+/*
+ * Writes a batch of elements to FIFO
+ *  Each pass moves every element that fits with one critical section and one index update
+ *  FIFO_BLOCK waits until there is room for the rest, or as much of it as the FIFO holds
+ *  Elements that do not fit are handled by the FIFO's fifoFull_t and count as lost
+ *  Only writes that cannot block may come from an interrupt
+ *  Param "FIFO": chooses which buffer we want to write to
+ *        "data": elements being put into FIFO
+ *        "count": elements to write
+ *        "timeoutMS": longest time to wait for room in ms, 0 never blocks, or WAIT_FOREVER
+ *  Returns: elements written, all of them when overwriting the oldest data
+ */
+int32_t writeFIFOBlock(fifoHandle_t FIFO, const void *data, uint32_t count, uint32_t timeoutMS);
 
 /*********************************************** Public Functions *********************************************************************/
 
 
+/*********************************************** Kernel Functions *********************************************************************/
+
+/*
+ * Passes on the wakeups a thread held back at the front of a FIFO wait queue, for a thread taken out of one without being woken
+ *  - Must be called with interrupts disabled, after the thread is out of the queue and its count is given back
+ *  - Queues that are not a FIFO's are left alone
+ * Param "queue": wait queue the thread was blocked on
+ */
+void G8RTOS_AbandonFIFOWait(semaphore_t *queue);
+
+/*********************************************** Kernel Functions *********************************************************************/
+
 #endif /* G8RTOS_G8RTOS_IPC_H_ */
@@ -0,0 +1,283 @@
+/*
+ * G8RTOS_Mutex.c
+ */
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+#include <stdint.h>
+#include "msp.h"
+#include "BSP.h"
+#include "G8RTOS_Mutex.h"
+#include "G8RTOS_CriticalSection.h"
+#include "G8RTOS_Scheduler.h"
+#include "G8RTOS.h"
+#include "G8RTOS_Trace.h"
+#include "G8RTOS_Port.h"
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+
+/*********************************************** Private Functions ********************************************************************/
+
+/*
+ * Highest priority a thread needs for the mutexes it holds
+ *  - Its own priority, the ceilings of its mutexes and the first waiter of each, which is the highest one
+ * Param "thread": thread to check
+ * Returns: priority, 0 is the highest
+ */
+static uint8_t HeldPriority(tcb_t *thread)
+{
+    uint8_t priority = thread->basePriority;
+
+    for(mutex_t *m = thread->heldMutexes; m != 0; m = m->nextHeld)
+    {
+        if(m->ceiling < priority)
+        {
+            priority = m->ceiling;
+        }
+        if(m->waiters.waiters != 0 && m->waiters.waiters->priority < priority)
+        {
+            priority = m->waiters.waiters->priority;
+        }
+    }
+    return priority;
+}
+
+/*
+ * Makes a thread the owner of a free mutex
+ * Param "m": mutex that is free
+ * Param "thread": new owner
+ */
+static void TakeMutex(mutex_t *m, tcb_t *thread)
+{
+    m->owner = thread;
+    m->lockCount = 1;
+    m->nextHeld = thread->heldMutexes;
+    thread->heldMutexes = m;
+}
+
+/*
+ * Takes a mutex out of its owner's list of held mutexes
+ * Param "m": mutex that is held
+ */
+static void DropMutex(mutex_t *m)
+{
+    mutex_t **link = &m->owner->heldMutexes;
+
+    while(*link != m)
+    {
+        link = &(*link)->nextHeld;
+    }
+    *link = m->nextHeld;
+
+    m->owner = 0;
+    m->lockCount = 0;
+    m->nextHeld = 0;
+}
+
+/*
+ * Gives a mutex that was just dropped to the highest priority waiter, which becomes ready
+ *  - New owner takes on the priority of the waiters left behind it
+ * Param "m": mutex with no owner
+ * Returns: new owner, or 0 if nothing was waiting
+ */
+static tcb_t *HandOff(mutex_t *m)
+{
+    tcb_t *thread = m->waiters.waiters;
+
+    if(thread == 0)
+    {
+        return 0;
+    }
+
+    thread->waitingMutex = 0;
+    TakeMutex(m, thread);
+
+    m->waiters.count++;
+    G8RTOS_UnblockThread(&m->waiters);
+    G8RTOS_SetPriority(thread, HeldPriority(thread));
+
+    return thread;
+}
+
+/*********************************************** Private Functions ********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Initializes a mutex as unlocked
+ * Param "m": Pointer to mutex
+ * Param "ceiling": Priority its owner runs at, 0 (highest) to IDLE_PRIORITY, or MUTEX_NO_CEILING
+ * THIS IS A CRITICAL SECTION
+ */
+void G8RTOS_InitMutex(mutex_t *m, uint8_t ceiling)
+{
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    m->owner = 0;
+    m->lockCount = 0;
+    m->ceiling = ceiling;
+    m->nextHeld = 0;
+    G8RTOS_InitSemaphore(&m->waiters, 0, SEMAPHORE_PRIORITY);
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+}
+
+/*
+ * Locks a mutex, blocking until its owner unlocks it
+ *  - The owner runs at least at the priority of the caller until then
+ *  - Locking a mutex the caller already holds only counts up, it must be unlocked as many times
+ * Param "m": Pointer to mutex
+ * Returns: SUCCESS once the caller owns the mutex,
+ *          ERROR without locking if the caller has a higher priority than the mutex's ceiling
+ * THIS IS A CRITICAL SECTION
+ */
+int32_t G8RTOS_LockMutex(mutex_t *m)
+{
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    tcb_t *thread = CurrentlyRunningThread;
+
+    //Ceiling has to be at least as high as every thread locking the mutex
+    if(m->ceiling != MUTEX_NO_CEILING && thread->basePriority < m->ceiling && m->owner != thread)
+    {
+        EndCriticalSection(priMask);
+        return ERROR;
+    }
+
+    G8RTOS_TRACE(TRACE_MUTEX_LOCK, m);
+
+    if(m->owner == 0)
+    {
+        //Free, so the caller takes it and moves up to the ceiling
+        TakeMutex(m, thread);
+        G8RTOS_SetPriority(thread, HeldPriority(thread));
+    }
+    else if(m->owner == thread)
+    {
+        m->lockCount++;
+    }
+    else
+    {
+        G8RTOS_TRACE(TRACE_MUTEX_BLOCK, m);
+
+        //Lends the caller's priority to the owner, and on to the owner of any mutex that one is blocked on
+        for(mutex_t *next = m; next != 0 && next->owner->priority > thread->priority; next = next->owner->waitingMutex)
+        {
+            G8RTOS_SetPriority(next->owner, thread->priority);
+        }
+
+        //Waits in priority order, the unlocking thread makes the caller the owner before waking it
+        thread->waitingMutex = m;
+        m->waiters.count--;
+        G8RTOS_BlockThread(&m->waiters, WAIT_FOREVER);
+
+        //Enables interrupts
+        EndCriticalSection(priMask);
+
+        //Sets PendSV flag, to yield CPU
+        G8RTOS_PendSV();
+        return SUCCESS;
+    }
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+    return SUCCESS;
+}
+
+/*
+ * Unlocks a mutex
+ *  - Hands it to the highest priority waiter, if any
+ *  - Caller drops back to the highest priority it still needs for the mutexes it holds
+ * Param "m": Pointer to mutex
+ * Returns: SUCCESS, or ERROR if the caller does not own the mutex, which is left as it is
+ * THIS IS A CRITICAL SECTION
+ */
+int32_t G8RTOS_UnlockMutex(mutex_t *m)
+{
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    tcb_t *thread = CurrentlyRunningThread;
+
+    if(m->owner != thread)
+    {
+        EndCriticalSection(priMask);
+        return ERROR;
+    }
+
+    G8RTOS_TRACE(TRACE_MUTEX_UNLOCK, m);
+
+    //Still locked by an outer lock of the same owner
+    if(--m->lockCount != 0)
+    {
+        EndCriticalSection(priMask);
+        return SUCCESS;
+    }
+
+    DropMutex(m);
+
+    //Gives up what was inherited or taken from the ceiling for this mutex
+    uint8_t oldPriority = thread->priority;
+    G8RTOS_SetPriority(thread, HeldPriority(thread));
+
+    tcb_t *owner = HandOff(m);
+
+    //Switches if the new owner, or a thread that was kept waiting by the raised priority, should run now
+    if(thread->priority > oldPriority || (owner != 0 && owner->priority < thread->priority))
+    {
+        G8RTOS_PendSV();
+    }
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+    return SUCCESS;
+}
+
+/*********************************************** Public Functions *********************************************************************/
+
+
+/*********************************************** Kernel Functions *********************************************************************/
+
+/*
+ * Hands every mutex a thread still holds to its next waiter, for a thread that is ending
+ *  - Must be called with interrupts disabled
+ * Param "thread": thread that is ending
+ */
+void G8RTOS_AbandonMutexes(tcb_t *thread)
+{
+    while(thread->heldMutexes != 0)
+    {
+        mutex_t *m = thread->heldMutexes;
+        DropMutex(m);
+        HandOff(m);
+    }
+}
+
+/*
+ * Takes back the priority a thread lent along the chain of owners, for a waiter that is ending
+ *  - Must be called with interrupts disabled, once the thread is out of the mutex's wait queue
+ * Param "thread": thread that was waiting on a mutex
+ */
+void G8RTOS_AbandonMutexWait(tcb_t *thread)
+{
+    mutex_t *m = thread->waitingMutex;
+    thread->waitingMutex = 0;
+
+    //Each owner drops to what it still needs, an owner that keeps its priority lent nothing further on
+    for(; m != 0; m = m->owner->waitingMutex)
+    {
+        uint8_t priority = HeldPriority(m->owner);
+        if(m->owner->priority == priority)
+        {
+            break;
+        }
+        G8RTOS_SetPriority(m->owner, priority);
+    }
+}
+
+/*********************************************** Kernel Functions *********************************************************************/
@@ -0,0 +1,92 @@
+/*
+ * G8RTOS_Mutex.h
+ *
+ * Mutexes for resources held across slow operations, like the I2C buses
+ *  - A mutex has an owner, only the owner may unlock it and it may lock it again without blocking
+ *  - Priority inheritance: a thread blocked on a mutex lends its priority to the owner,
+ *    and along the chain of owners if that one is blocked on another mutex
+ *  - Optional priority ceiling: the owner runs at the ceiling for as long as it holds the mutex
+ *  - Waiters are woken highest priority first and the mutex is handed straight to them
+ */
+
+#ifndef G8RTOS_MUTEX_H_
+#define G8RTOS_MUTEX_H_
+
+#include <stdint.h>
+#include "G8RTOS_Semaphores.h"
+
+/*********************************************** Defines ******************************************************************************/
+
+/* Ceiling of a mutex that only uses priority inheritance */
+#define MUTEX_NO_CEILING 0xFF
+
+/*********************************************** Defines ******************************************************************************/
+
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+/*
+ * Mutex typedef
+ */
+typedef struct mutex_t
+{
+    struct tcb_t *owner; //Thread holding the mutex, 0 when it is free
+    uint32_t lockCount; //Times the owner has locked it and not unlocked it yet
+    uint8_t ceiling; //Priority the owner runs at while holding it, MUTEX_NO_CEILING for none
+    semaphore_t waiters; //Threads blocked on the mutex, highest priority first
+    struct mutex_t *nextHeld; //Next mutex held by the same owner
+}mutex_t;
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Initializes a mutex as unlocked
+ * Param "m": Pointer to mutex
+ * Param "ceiling": Priority its owner runs at, 0 (highest) to IDLE_PRIORITY, or MUTEX_NO_CEILING
+ */
+void G8RTOS_InitMutex(mutex_t *m, uint8_t ceiling);
+
+/*
+ * Locks a mutex, blocking until its owner unlocks it
+ *  - The owner runs at least at the priority of the caller until then
+ *  - Locking a mutex the caller already holds only counts up, it must be unlocked as many times
+ *  - Not to be used from an interrupt
+ * Param "m": Pointer to mutex
+ * Returns: SUCCESS once the caller owns the mutex,
+ *          ERROR without locking if the caller has a higher priority than the mutex's ceiling
+ */
+int32_t G8RTOS_LockMutex(mutex_t *m);
+
+/*
+ * Unlocks a mutex
+ *  - Hands it to the highest priority waiter, if any
+ *  - Caller drops back to the highest priority it still needs for the mutexes it holds
+ * Param "m": Pointer to mutex
+ * Returns: SUCCESS, or ERROR if the caller does not own the mutex, which is left as it is
+ */
+int32_t G8RTOS_UnlockMutex(mutex_t *m);
+
+/*********************************************** Public Functions *********************************************************************/
+
+
+/*********************************************** Kernel Functions *********************************************************************/
+
+/*
+ * Hands every mutex a thread still holds to its next waiter, for a thread that is ending
+ *  - Must be called with interrupts disabled
+ * Param "thread": thread that is ending
+ */
+void G8RTOS_AbandonMutexes(struct tcb_t *thread);
+
+/*
+ * Takes back the priority a thread lent along the chain of owners, for a waiter that is ending
+ *  - Must be called with interrupts disabled, once the thread is out of the mutex's wait queue
+ * Param "thread": thread that was waiting on a mutex
+ */
+void G8RTOS_AbandonMutexWait(struct tcb_t *thread);
+
+/*********************************************** Kernel Functions *********************************************************************/
+
+#endif /* G8RTOS_MUTEX_H_ */
@@ -0,0 +1,206 @@
+/*
+ * G8RTOS_Pool.c
+ */
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+#include <stdint.h>
+#include "msp.h"
+#include "BSP.h"
+#include "G8RTOS_Pool.h"
+#include "G8RTOS_CriticalSection.h"
+#include "G8RTOS.h"
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+
+/*********************************************** Private Functions ********************************************************************/
+
+/*
+ * Returns: header of a buffer, kept just in front of its data
+ * Param "buffer": data of the buffer
+ */
+static inline bufferHeader_t *Header(void *buffer)
+{
+    return (bufferHeader_t *)buffer - 1;
+}
+
+/*********************************************** Private Functions ********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Initializes a pool with every buffer free
+ * Param "p": Pointer to pool
+ * Param "storage": storage declared with POOL_STORAGE, used by the pool for good
+ * Param "blocks": buffers in the pool
+ * Param "size": bytes of data in every buffer
+ * THIS IS A CRITICAL SECTION
+ */
+void G8RTOS_InitPool(pool_t *p, void *storage, uint32_t blocks, uint32_t size)
+{
+    uint8_t *block = storage;
+
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    //Links every buffer into the free list, the first one in storage is taken first
+    p->free = 0;
+    for(uint32_t i = blocks; i > 0; i--)
+    {
+        bufferHeader_t *header = (bufferHeader_t *)(block + (i - 1) * POOL_BLOCK_SIZE(size));
+        header->pool = p;
+        header->next = p->free;
+        header->references = 0;
+        header->length = 0;
+        p->free = header;
+    }
+    p->blockSize = size;
+    G8RTOS_InitSemaphore(&p->available, blocks, SEMAPHORE_PRIORITY);
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+}
+
+/*
+ * Takes a free buffer from a pool, holding its only reference
+ *  - A timeout of 0 never blocks, so it may be called from an interrupt
+ * Param "p": Pointer to pool
+ * Param "timeoutMS": longest time to wait for a free buffer in ms, or WAIT_FOREVER
+ * Returns: data of the buffer, with a length of 0, or 0 if none was free in time
+ * THIS IS A CRITICAL SECTION
+ */
+void *G8RTOS_AllocBuffer(pool_t *p, uint32_t timeoutMS)
+{
+    //Counts the buffer out of the pool first, so one is sure to be on the free list
+    if(G8RTOS_WaitSemaphoreTimeout(&p->available, timeoutMS) == ERROR)
+    {
+        return 0;
+    }
+
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    bufferHeader_t *header = p->free;
+    p->free = header->next;
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+
+    header->next = 0;
+    header->references = 1;
+    header->length = 0;
+    return header + 1;
+}
+
+/*
+ * Adds a reference to a buffer, for each extra thread or FIFO it is handed to
+ * Param "buffer": data of the buffer
+ * THIS IS A CRITICAL SECTION
+ */
+void G8RTOS_RetainBuffer(void *buffer)
+{
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    Header(buffer)->references++;
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+}
+
+/*
+ * Drops a reference to a buffer, the last one puts it back in its pool, may be called from an interrupt
+ * Param "buffer": data of the buffer, not used again by the caller
+ * THIS IS A CRITICAL SECTION
+ */
+void G8RTOS_ReleaseBuffer(void *buffer)
+{
+    bufferHeader_t *header = Header(buffer);
+    pool_t *p = header->pool;
+
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    //Still held by someone else
+    if(--header->references != 0)
+    {
+        EndCriticalSection(priMask);
+        return;
+    }
+
+    header->next = p->free;
+    p->free = header;
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+
+    //Wakes a thread waiting for a buffer
+    G8RTOS_SignalSemaphore(&p->available);
+}
+
+/*
+ * Sets the bytes of a buffer that are in use
+ * Param "buffer": data of the buffer
+ * Param "length": bytes in use, at most the pool's block size
+ */
+void G8RTOS_SetBufferLength(void *buffer, uint32_t length)
+{
+    Header(buffer)->length = length;
+}
+
+/*
+ * Returns: Bytes of a buffer that are in use
+ * Param "buffer": data of the buffer
+ */
+uint32_t G8RTOS_GetBufferLength(void *buffer)
+{
+    return Header(buffer)->length;
+}
+
+/*
+ * Returns: Bytes of data every buffer of a pool holds
+ * Param "buffer": data of the buffer
+ */
+uint32_t G8RTOS_GetBufferSize(void *buffer)
+{
+    return Header(buffer)->pool->blockSize;
+}
+
+/*
+ * Hands a buffer to whoever reads a FIFO of buffers, the caller's reference goes with it
+ *  - A buffer that is not written is released, so the caller never uses it again either way
+ * Param "FIFO": FIFO of buffers
+ * Param "buffer": data of the buffer
+ * Param "timeoutMS": longest time to wait for room in ms, 0 never blocks, or WAIT_FOREVER
+ * Returns: SUCCESS, or ERROR if the buffer was released instead
+ */
+int G8RTOS_SendBuffer(fifoHandle_t FIFO, void *buffer, uint32_t timeoutMS)
+{
+    if(writeFIFOTimeout(FIFO, &buffer, timeoutMS) == ERROR)
+    {
+        G8RTOS_ReleaseBuffer(buffer);
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/*
+ * Takes a buffer from a FIFO of buffers, with the reference it was sent with
+ * Param "FIFO": FIFO of buffers
+ * Param "timeoutMS": longest time to wait in ms, 0 never blocks, or WAIT_FOREVER
+ * Returns: data of the buffer, or 0 if none came in time
+ */
+void *G8RTOS_ReceiveBuffer(fifoHandle_t FIFO, uint32_t timeoutMS)
+{
+    void *buffer;
+
+    if(readFIFOTimeout(FIFO, &buffer, timeoutMS) == ERROR)
+    {
+        return 0;
+    }
+    return buffer;
+}
+
+/*********************************************** Public Functions *********************************************************************/
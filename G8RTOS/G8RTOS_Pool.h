@@ -0,0 +1,129 @@
+/*
+ * G8RTOS_Pool.h
+ *
+ * Buffer pools, fixed size blocks handed between threads and interrupts without copying them
+ *  - A buffer is a plain pointer to its data, so it can be given straight to a driver, like readBurstI2C
+ *  - Every buffer counts its references, the last one released puts it back in its pool
+ *  - Allocating without waiting and releasing may be done from an interrupt
+ *  - A FIFO of buffers passes the pointers only, whoever reads one owns the reference that was written
+ */
+
+#ifndef G8RTOS_POOL_H_
+#define G8RTOS_POOL_H_
+
+#include <stdint.h>
+#include "G8RTOS_Semaphores.h"
+#include "G8RTOS_IPC.h"
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+/*
+ * Kept in front of the data of every buffer
+ */
+typedef struct bufferHeader_t
+{
+    struct pool_t *pool; //Pool the buffer goes back to
+    struct bufferHeader_t *next; //Next free buffer, while the buffer is free
+    uint32_t references; //Holders of the buffer, 0 while it is free
+    uint32_t length; //Bytes of the data in use, set by whoever fills the buffer
+}bufferHeader_t;
+
+/*
+ * Pool typedef
+ */
+typedef struct pool_t
+{
+    bufferHeader_t *free; //Free buffers, linked through their headers
+    semaphore_t available; //Free buffers, threads waiting for one block on it
+    uint32_t blockSize; //Bytes of data in every buffer
+}pool_t;
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+
+/*********************************************** Defines ******************************************************************************/
+
+/* Bytes one buffer takes in the storage of a pool, its data is kept 8 byte aligned */
+#define POOL_BLOCK_SIZE(size) (sizeof(bufferHeader_t) + (((size) + 7) & ~7))
+
+/* Declares storage for a pool of "blocks" buffers of "size" bytes, aligned for any data */
+#define POOL_STORAGE(name, blocks, size) uint64_t name[((blocks) * POOL_BLOCK_SIZE(size) + 7) / 8]
+
+/*********************************************** Defines ******************************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Initializes a pool with every buffer free
+ * Param "p": Pointer to pool
+ * Param "storage": storage declared with POOL_STORAGE, used by the pool for good
+ * Param "blocks": buffers in the pool
+ * Param "size": bytes of data in every buffer
+ */
+void G8RTOS_InitPool(pool_t *p, void *storage, uint32_t blocks, uint32_t size);
+
+/*
+ * Takes a free buffer from a pool, holding its only reference
+ *  - A timeout of 0 never blocks, so it may be called from an interrupt
+ * Param "p": Pointer to pool
+ * Param "timeoutMS": longest time to wait for a free buffer in ms, or WAIT_FOREVER
+ * Returns: data of the buffer, with a length of 0, or 0 if none was free in time
+ */
+void *G8RTOS_AllocBuffer(pool_t *p, uint32_t timeoutMS);
+
+/*
+ * Adds a reference to a buffer, for each extra thread or FIFO it is handed to
+ * Param "buffer": data of the buffer
+ */
+void G8RTOS_RetainBuffer(void *buffer);
+
+/*
+ * Drops a reference to a buffer, the last one puts it back in its pool, may be called from an interrupt
+ * Param "buffer": data of the buffer, not used again by the caller
+ */
+void G8RTOS_ReleaseBuffer(void *buffer);
+
+/*
+ * Sets the bytes of a buffer that are in use
+ * Param "buffer": data of the buffer
+ * Param "length": bytes in use, at most the pool's block size
+ */
+void G8RTOS_SetBufferLength(void *buffer, uint32_t length);
+
+/*
+ * Returns: Bytes of a buffer that are in use
+ * Param "buffer": data of the buffer
+ */
+uint32_t G8RTOS_GetBufferLength(void *buffer);
+
+/*
+ * Returns: Bytes of data every buffer of a pool holds
+ * Param "buffer": data of the buffer
+ */
+uint32_t G8RTOS_GetBufferSize(void *buffer);
+
+/*
+ * Hands a buffer to whoever reads a FIFO of buffers, the caller's reference goes with it
+ *  - The FIFO's elements are sizeof(void *), and it must not overwrite the oldest data,
+ *    an overwritten buffer would never be released
+ *  - A buffer that is not written is released, so the caller never uses it again either way
+ * Param "FIFO": FIFO of buffers
+ * Param "buffer": data of the buffer
+ * Param "timeoutMS": longest time to wait for room in ms, 0 never blocks, or WAIT_FOREVER
+ * Returns: SUCCESS, or ERROR if the buffer was released instead
+ */
+int G8RTOS_SendBuffer(fifoHandle_t FIFO, void *buffer, uint32_t timeoutMS);
+
+/*
+ * Takes a buffer from a FIFO of buffers, with the reference it was sent with
+ *  - Caller releases it once done with it
+ * Param "FIFO": FIFO of buffers
+ * Param "timeoutMS": longest time to wait in ms, 0 never blocks, or WAIT_FOREVER
+ * Returns: data of the buffer, or 0 if none came in time
+ */
+void *G8RTOS_ReceiveBuffer(fifoHandle_t FIFO, uint32_t timeoutMS);
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif /* G8RTOS_POOL_H_ */
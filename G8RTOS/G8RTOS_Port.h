@@ -0,0 +1,54 @@
+/*
+ * G8RTOS_Port.h
+ *
+ * What the kernel needs from the processor it runs on
+ *  - Cortex-M4: G8RTOS_SchedulerASM.s, G8RTOS_CriticalSection.s, SysTick and the definitions below
+ *  - Linux: HostPort/, selected by building with G8RTOS_HOST
+ */
+
+#ifndef G8RTOS_PORT_H_
+#define G8RTOS_PORT_H_
+
+#include <stdint.h>
+#include "msp.h"
+
+/* Thread Control Block, defined in G8RTOS_Structures.h */
+struct tcb_t;
+
+/*********************************************** Public Functions *********************************************************************/
+
+#ifdef G8RTOS_HOST
+
+#include "G8RTOS_Port_Linux.h"
+
+#else
+
+/*
+ * Requests a context switch
+ *  - PendSV takes it once interrupts are enabled and no other interrupt is running
+ *  - With interrupts enabled the switch has happened by the time this returns, so a blocked caller
+ *    reads timedOut or its event mask only after it was woken
+ */
+static inline void G8RTOS_PendSV(void)
+{
+    SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk;
+
+    //Store has to reach the SCB before the next instruction, which PendSV then preempts
+    __DSB();
+    __ISB();
+}
+
+#endif
+
+/*
+ * Builds the first context of a new thread, so the first switch to it starts "entry"
+ * Param "thread": thread control block of the new thread, its sp is set here
+ * Param "stackTop": one past the highest word of the thread's stack
+ * Param "entry": thread function
+ * Param "exit": function the thread ends in if "entry" returns
+ */
+void G8RTOS_PortInitContext(struct tcb_t *thread, int32_t *stackTop, void (*entry)(void), void (*exit)(void));
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif /* G8RTOS_PORT_H_ */
@@ -9,6 +9,10 @@
 #include "BSP.h"
 #include "G8RTOS_Scheduler.h"
 #include "G8RTOS.h"
+#include "G8RTOS_Tickless.h"
+#include "G8RTOS_Time.h"
+#include "G8RTOS_Trace.h"
+#include "G8RTOS_Port.h"
 #include <stdint.h>
 /*
  * G8RTOS_Start exists in asm
@@ -31,26 +35,94 @@ extern tcb_t * CurrentlyRunningThread;
 /* Status Register with the Thumb-bit Set */
 #define THUMBBIT 0x01000000
 
+/* Exception return to thread mode on PSP with a basic (no FP) frame */
+#define EXC_RETURN_THREAD_PSP 0xFFFFFFFD
+
+/* Words in a new thread's fake context: R4-R11, EXC_RETURN, then R0-R3, R12, LR, PC, xPSR */
+#define FAKE_CONTEXT_WORDS 17
+
+/* Stack sizes are rounded up to a multiple of this many bytes to keep stacks 8 byte aligned */
+#define STACK_ALIGNMENT 8
+
+/* Thread ids hold the thread control block index in the low bits and a serial number above it */
+#define THREADID_SHIFT 8
+#define THREADID_INDEX_MASK 0xFF
+#define THREADID_SERIAL_MASK 0x7FFFFF
+
+/* Doorbells there can be, one bit each in RungDoorbells */
+#define MAX_DOORBELLS 32
+
 /*********************************************** Defines ******************************************************************************/
 
 
 /*********************************************** Data Structures Used *****************************************************************/
 
+/* Free Stack
+ *	- Header written at the bottom of a stack that is not in use
+ */
+typedef struct freeStack_t
+{
+    struct freeStack_t *next; //Holds pointer to the next free stack, higher in memory
+    uint32_t size; //Size of this free stack in bytes
+}freeStack_t;
+
 /* Thread Control Blocks
  *	- An array of thread control blocks to hold pertinent information for each thread
  */
 static tcb_t threadControlBlocks[MAX_THREADS];
 
-/* Thread Stacks
- *	- An array of arrays that will act as individual stacks for each thread
+/* Stack Arena
+ *	- One block of memory that every thread stack is carved from
+ *	- Declared as 64 bit words so every stack is 8 byte aligned
  */
-static int32_t threadStacks[MAX_THREADS][STACKSIZE];
+static uint64_t StackArena[STACK_ARENA_SIZE / 8];
 
 /* Periodic Event Threads
  * - An array of periodic events to hold pertinent information for each thread
  */
 static ptcb_t Pthread[MAXPTHREADS];
 
+/* Periodic Event Heap
+ * - Min heap of the periodic events, the one with the earliest release time is at index 0
+ */
+static ptcb_t *PeriodicHeap[MAXPTHREADS];
+
+/* Timer Queue
+ * - Deferred periodic events with releases the timer thread has not run yet, oldest first
+ */
+static ptcb_t *TimerQueueHead;
+static ptcb_t *TimerQueueTail;
+
+/* Timer Releases
+ * - Counts releases waiting in the timer queue, the timer thread blocks on it
+ */
+static semaphore_t TimerReleases;
+
+/* Ready Lists
+ * - One circular doubly linked list of ready threads per priority level
+ * - The front of each list is the next thread of that priority to run
+ */
+static tcb_t *ReadyList[NUM_PRIORITIES];
+
+/* Ready Bitmap
+ * - Bit (31 - priority) is set while the ready list of that priority is not empty,
+ *   so the number of leading zeros is the highest ready priority
+ */
+static uint32_t ReadyMask;
+
+/* Sleep List
+ * - Doubly linked list of sleeping threads sorted from earliest to latest wake time
+ * - Sleeping threads are not in the ready set, so the SysTick only has to check the front
+ */
+static tcb_t *SleepList;
+
+/* Doorbells
+ * - Semaphores an interrupt has signaled without disabling interrupts or touching the semaphore
+ * - Ringing doorbell n only sets bit (31 - n) of RungDoorbells, the scheduler signals the semaphore on the next switch
+ */
+static semaphore_t *Doorbells[MAX_DOORBELLS];
+static volatile uint32_t RungDoorbells;
+
 /*********************************************** Data Structures Used *****************************************************************/
 
 
@@ -66,6 +138,77 @@ static uint32_t NumberOfThreads;
  */
 static uint32_t NumberOfPthreads;
 
+/*
+ * Current Number of Doorbells added
+ */
+static uint32_t NumberOfDoorbells;
+
+/*
+ * Thread control blocks that are not in use, linked through next
+ */
+static tcb_t *FreeThreads;
+
+/*
+ * Thread that ended itself, its control block and stack go back once it has been switched out
+ */
+static tcb_t *ExitedThread;
+
+/*
+ * Bytes of the stack arena that have been carved out at least once, stacks are carved from the bottom up
+ */
+static uint32_t StackArenaTop;
+
+/*
+ * Stacks that were given back, sorted by address and linked through their first bytes
+ */
+static freeStack_t *FreeStacks;
+
+/*
+ * Counts every thread ever added, makes ids of recycled thread control blocks unique
+ */
+static uint32_t NextThreadSerial;
+
+/*
+ * Id of the kernel idle thread, which cannot be killed
+ */
+static threadId_t IdleThreadId;
+
+/*
+ * Set once G8RTOS_Launch starts the first thread
+ */
+static bool Launched;
+
+/*
+ * Number of SysTick cycles in one tick
+ */
+static uint32_t CyclesPerTick;
+
+/*
+ * Most ticks the idle thread can skip with one SysTick period
+ */
+static uint32_t MaxIdleTicks;
+
+/*
+ * Cycles spent in periodic handlers and in interrupt handlers
+ */
+static uint64_t PeriodicCycles;
+static uint64_t IsrCycles;
+
+#if (CPU_ACCOUNTING == 1)
+/*
+ * Cycle counter the code running now is charged to, and the time the charge started
+ */
+static uint64_t *ChargedCycles;
+static uint64_t ChargeStart;
+
+/*
+ * Time and counters at the last CPU load snapshot
+ */
+static uint64_t SnapshotTime;
+static uint64_t SnapshotPeriodicCycles;
+static uint64_t SnapshotIsrCycles;
+#endif
+
 /*********************************************** Private Variables ********************************************************************/
 
 
@@ -81,276 +224,1609 @@ static void InitSysTick(uint32_t numCycles)
     SysTick_Config(numCycles); //Configures SysTick overflow by amount of cycles
 }
 
+#if (CPU_ACCOUNTING == 1)
 /*
- * Chooses the next thread to run.
- * Lab 2 Scheduling Algorithm:
- * 	- Simple Round Robin: Choose the next running thread by selecting the currently running thread's next pointer
- * 	- Check for sleeping and blocked threads
+ * Charges the time since the last charge to the current counter and switches to another one
+ * Param "cycles": counter charged from now on
+ * Returns: counter that was charged until now
+ * THIS IS A CRITICAL SECTION
  */
-void G8RTOS_Scheduler()
+static uint64_t *ChargeTo(uint64_t *cycles)
 {
-    while(1)
-    {
-        //Changes currently running thread to next
-        CurrentlyRunningThread = CurrentlyRunningThread->next;
+    int32_t priMask = StartCriticalSection();
 
-        //If currently running thread is blocked OR asleep, next one is used
-        if(CurrentlyRunningThread->blocked || CurrentlyRunningThread->asleep)
-        {
-            continue;
-        }
-        //If not blocked or asleep, return
-        return;
+    uint64_t now = G8RTOS_GetTimeCycles();
+    uint64_t *previous = ChargedCycles;
+
+    //A reading taken in a handler that preempted SysTick_Handler before it counted its tick is behind, so it is skipped
+    if(previous != 0 && now > ChargeStart)
+    {
+        *previous += now - ChargeStart;
+        ChargeStart = now;
     }
+    ChargedCycles = cycles;
+
+    EndCriticalSection(priMask);
+    return previous;
 }
 
+/*
+ * Share of a window in hundredths of a percent
+ */
+static uint32_t Load(uint64_t cycles, uint64_t window)
+{
+    return (uint32_t)(cycles * 10000 / window);
+}
+#else
+static inline uint64_t *ChargeTo(uint64_t *cycles)
+{
+    return 0;
+}
+#endif
 
 /*
- * SysTick Handler
- * The Systick Handler now will increment the system time,
- * set the PendSV flag to start the scheduler,
- * and be responsible for handling sleeping and periodic threads
+ * Compares two points in time so that SystemTime wrapping around does not matter
+ * Returns: true if time "a" is before time "b"
  */
-void SysTick_Handler()
+static inline bool TimeBefore(uint32_t a, uint32_t b)
 {
-    //Increments system time
-    SystemTime++;
+    return (int32_t)(a - b) < 0;
+}
 
-    //Checks periodic threads to see if they are to be dealt with
-    for(uint8_t i = 0; i < NumberOfPthreads; ++i)
-    {
-        //If execute time is equal to system time
-        if(Pthread[i].executeTime <= SystemTime)
-        {
-            //Defines new execute time to be "period" ms from now
-            Pthread[i].executeTime = Pthread[i].period + SystemTime + Pthread[i].currentTime;
+/*
+ * Inserts a thread in the sleep list, keeping it sorted by wake time
+ * Threads with the same wake time are woken in the order they went to sleep
+ * Param "thread": thread with its sleepCount set to the wake time
+ */
+static void SleepInsert(tcb_t *thread)
+{
+    tcb_t *prev = 0;
+    tcb_t *temp = SleepList;
 
-            //Runs Periodic thread
-            (*(Pthread[i].Handler))();
-        }
+    //Finds the first thread that wakes up later than the new one
+    while(temp != 0 && !TimeBefore(thread->sleepCount, temp->sleepCount))
+    {
+        prev = temp;
+        temp = temp->sleepNext;
     }
 
-    //Wakes up threads that need to be woken up
-    tcb_t *temp = CurrentlyRunningThread;
-    for(uint8_t i = 0; i < NumberOfThreads; ++i)
+    //Links the thread between prev and temp
+    thread->sleepPrev = prev;
+    thread->sleepNext = temp;
+    if(temp != 0)
     {
-        //If thread is asleep
-        if(temp->asleep)
-        {
-            //If thread reaches wake up time, then wake it up threadControlBlocks[i].sleepCount == SystemTime
-            if(temp->sleepCount == SystemTime)
-            {
-                //Thread woken up and sleep count made 0
-                temp->asleep = false;
-                temp->sleepCount = 0;
-            }
-        }
-        //Points to the next thread
-        temp = temp->next;
+        temp->sleepPrev = thread;
+    }
+    if(prev != 0)
+    {
+        prev->sleepNext = thread;
+    }
+    else
+    {
+        SleepList = thread;
     }
-
-    //Sets PendSV flag
-    SCB->ICSR |= (1<<28);
 }
 
-/*********************************************** Private Functions ********************************************************************/
-
-
-/*********************************************** Public Variables *********************************************************************/
-
-/* Holds the current time for the whole System */
-uint32_t SystemTime;
-
-/*********************************************** Public Variables *********************************************************************/
-
-
-/*********************************************** Public Functions *********************************************************************/
-
 /*
- * Sets variables to an initial state (system time and number of threads)
- * Enables board for highest speed clock and disables watchdog
+ * Takes a thread out of the sleep list
+ * Param "thread": sleeping thread
  */
-void G8RTOS_Init()
+static void SleepRemove(tcb_t *thread)
 {
-    //Sets system time to 0
-    SystemTime = 0;
-
-    //Sets number of threads to 0
-    NumberOfThreads = 0;
-
-    //Sets number of periodic threads to 0
-    NumberOfPthreads = 0;
-
-    //Initializes board
-    BSP_InitBoard();
+    if(thread->sleepPrev != 0)
+    {
+        thread->sleepPrev->sleepNext = thread->sleepNext;
+    }
+    else
+    {
+        SleepList = thread->sleepNext;
+    }
+    if(thread->sleepNext != 0)
+    {
+        thread->sleepNext->sleepPrev = thread->sleepPrev;
+    }
 }
 
 /*
- * Starts G8RTOS Scheduler
- * 	- Initializes the Systick
- * 	- Sets Context to first thread
- * Returns: Error Code for starting scheduler. This will only return if the scheduler fails
+ * Takes a stack from the stack arena
+ *  - Reuses the first free stack that is big enough, splitting off what it does not need
+ *  - Otherwise carves a new stack above every stack carved so far
+ * Param "size": size in bytes, already rounded to STACK_ALIGNMENT, updated to the size actually taken
+ * Returns: bottom of the stack, 0 if the arena is full
  */
-int G8RTOS_Launch()
+static int32_t *AllocateStack(uint32_t *size)
 {
-    //Sets currently running thread to first tcb
-    CurrentlyRunningThread = &threadControlBlocks[0];
+    freeStack_t *prev = 0;
+    freeStack_t *block = FreeStacks;
 
-    //Gets clock frequency
-    uint32_t clkFreq = ClockSys_GetSysFreq();
+    //First free stack that is big enough
+    while(block != 0 && block->size < *size)
+    {
+        prev = block;
+        block = block->next;
+    }
 
-    //Initializes SysTick
-    InitSysTick((clkFreq/1000));
+    if(block != 0)
+    {
+        freeStack_t *rest = block->next;
 
-    //Sets priorities for PENDSV and SysTick
-    NVIC_SetPriority(PendSV_IRQn, 7);
+        //What is too small to hold a thread stays with this one
+        if(block->size - *size >= MIN_STACKSIZE)
+        {
+            rest = (freeStack_t *)((uint8_t *)block + *size);
+            rest->next = block->next;
+            rest->size = block->size - *size;
+        }
+        else
+        {
+            *size = block->size;
+        }
 
-    //Call G8RTOS_Start
-    G8RTOS_Start();
+        //Unlinks the stack from the free list
+        if(prev != 0)
+        {
+            prev->next = rest;
+        }
+        else
+        {
+            FreeStacks = rest;
+        }
+        return (int32_t *)block;
+    }
 
-    return ERROR;
-}
+    //Carves a new stack if there is room left
+    if(STACK_ARENA_SIZE - StackArenaTop >= *size)
+    {
+        int32_t *stack = (int32_t *)((uint8_t *)StackArena + StackArenaTop);
+        StackArenaTop += *size;
+        return stack;
+    }
 
+    return 0;
+}
 
 /*
- * Adds threads to G8RTOS Scheduler
- * 	- Checks if there are stil available threads to insert to scheduler
- * 	- Initializes the thread control block for the provided thread
- * 	- Initializes the stack for the provided thread to hold a "fake context"
- * 	- Sets stack tcb stack pointer to top of thread stack
- * 	- Sets up the next and previous tcb pointers in a round robin fashion
- * Param "threadToAdd": Void-Void Function to add as preemptable main thread
- * Returns: Error code for adding threads
+ * Gives a stack back to the stack arena
+ *  - Merges it with free stacks right below and above it
+ *  - A free stack at the top of what has been carved goes back to the uncarved part
+ * Param "stack": bottom of the stack
+ * Param "size": size in bytes
  */
-int G8RTOS_AddThread(void (*threadToAdd)(void))
+static void FreeStack(int32_t *stack, uint32_t size)
 {
-    //If maximum threads have not been reached
-    if(MAX_THREADS != NumberOfThreads)
+    freeStack_t *block = (freeStack_t *)stack;
+    freeStack_t *prev = 0;
+    freeStack_t *next = FreeStacks;
+
+    //Finds where the stack goes in the address sorted list
+    while(next != 0 && next < block)
+    {
+        prev = next;
+        next = next->next;
+    }
+
+    //Merges with the free stack right below, or links in after it
+    if(prev != 0 && (uint8_t *)prev + prev->size == (uint8_t *)block)
+    {
+        prev->size += size;
+        block = prev;
+    }
+    else
     {
-        //When no threads exist
-        if (!NumberOfThreads)
+        block->size = size;
+        if(prev != 0)
         {
-            //Makes new thread point to itself
-            threadControlBlocks[NumberOfThreads].prev = &threadControlBlocks[NumberOfThreads];
-            threadControlBlocks[NumberOfThreads].next = &threadControlBlocks[NumberOfThreads];
+            prev->next = block;
         }
         else
         {
-            //Makes new thread point to previous and head
-            threadControlBlocks[NumberOfThreads].prev = &threadControlBlocks[NumberOfThreads - 1];
-            threadControlBlocks[NumberOfThreads].next = &threadControlBlocks[0];
+            FreeStacks = block;
+        }
+    }
+    block->next = next;
+
+    //Merges with the free stack right above
+    if(next != 0 && (uint8_t *)block + block->size == (uint8_t *)next)
+    {
+        block->size += next->size;
+        block->next = next->next;
+    }
+
+    //Last free stack touching the uncarved part goes back to it
+    if(block->next == 0 && (uint8_t *)block + block->size == (uint8_t *)StackArena + StackArenaTop)
+    {
+        StackArenaTop -= block->size;
 
-            //Makes previous root and head point to new thread
-            threadControlBlocks[NumberOfThreads - 1].next = &threadControlBlocks[NumberOfThreads];
-            threadControlBlocks[0].prev = &threadControlBlocks[NumberOfThreads];
+        if(FreeStacks == block)
+        {
+            FreeStacks = 0;
+        }
+        else
+        {
+            freeStack_t *temp = FreeStacks;
+            while(temp->next != block)
+            {
+                temp = temp->next;
+            }
+            temp->next = 0;
         }
-        //Makes thread start awake
-        threadControlBlocks[NumberOfThreads].asleep = 0;
+    }
+}
 
-        //Makes thread sleep count equal 0
-        threadControlBlocks[NumberOfThreads].sleepCount = 0;
+/*
+ * Finds a living thread from its id
+ * Param "threadId": Id returned by G8RTOS_AddThread
+ * Returns: thread control block, 0 if the thread has ended
+ */
+static tcb_t *FindThread(threadId_t threadId)
+{
+    uint32_t index = threadId & THREADID_INDEX_MASK;
 
-        //Makes blocked semaphore 0
-        threadControlBlocks[NumberOfThreads].blocked = 0;
+    if(index < MAX_THREADS && threadControlBlocks[index].alive && threadControlBlocks[index].id == threadId)
+    {
+        return &threadControlBlocks[index];
+    }
+    return 0;
+}
 
+/*
+ * Puts a thread in the wait queue of a semaphore, in the semaphore's order
+ *  - FIFO semaphores and waiters of the same or higher priority at the back take constant time
+ * Param "s": semaphore the thread is blocked on
+ * Param "thread": thread that is out of the ready set
+ */
+static void WaitInsert(semaphore_t *s, tcb_t *thread)
+{
+    tcb_t *head = s->waiters;
 
-        //Sets thumbbit in xPSR
-        threadStacks[NumberOfThreads][STACKSIZE - 1] = THUMBBIT;
+    //If queue is empty, thread points to itself
+    if(head == 0)
+    {
+        thread->next = thread;
+        thread->prev = thread;
+        s->waiters = thread;
+        return;
+    }
 
-        //Sets PC to function pointer
-        threadStacks[NumberOfThreads][STACKSIZE - 2] = (uint32_t)threadToAdd;
+    //Thread goes behind the last waiter of the same or higher priority, FIFO semaphores always go at the back
+    tcb_t *after = head->prev;
+    if(s->order == SEMAPHORE_PRIORITY)
+    {
+        while(after->priority > thread->priority && after != head)
+        {
+            after = after->prev;
+        }
 
-        //Fills R0 to R14 with dummy values
-        for (uint8_t i = 3; i <= 16; i++)
-            threadStacks[NumberOfThreads][STACKSIZE - i] = 1;
+        //Every waiter has a lower priority, so thread becomes the new front
+        if(after->priority > thread->priority)
+        {
+            after = head->prev;
+            s->waiters = thread;
+        }
+    }
 
-        //Sets stack pointer to point to top of stack pointer address
-        threadControlBlocks[NumberOfThreads].sp = &threadStacks[NumberOfThreads][STACKSIZE - 16];
+    thread->prev = after;
+    thread->next = after->next;
+    after->next->prev = thread;
+    after->next = thread;
+}
 
-        //Increments number of threads
-        NumberOfThreads++;
+/*
+ * Takes a blocked thread out of the wait queue of its semaphore
+ * Param "thread": thread that is blocked
+ */
+static void WaitRemove(tcb_t *thread)
+{
+    semaphore_t *s = thread->blocked;
 
-        return SUCCESS;
+    //If thread is the only waiter, queue is empty
+    if(thread->next == thread)
+    {
+        s->waiters = 0;
     }
     else
     {
-        return ERROR;
+        //Unlinks thread from its neighbours
+        thread->prev->next = thread->next;
+        thread->next->prev = thread->prev;
+
+        //If thread was at the front, the one behind it moves up
+        if(s->waiters == thread)
+        {
+            s->waiters = thread->next;
+        }
     }
 }
 
+/*
+ * Makes a blocked thread ready, leaving the count of its semaphore to the caller
+ *  - Takes it out of the sleep list too if it was a timed wait
+ * Param "thread": thread that is blocked
+ */
+static void Wake(tcb_t *thread)
+{
+    WaitRemove(thread);
+    thread->blocked = 0;
+
+    //Signaled before its timeout
+    if(thread->asleep)
+    {
+        SleepRemove(thread);
+        thread->asleep = false;
+        thread->sleepCount = 0;
+    }
+
+    G8RTOS_AddReady(thread);
+    G8RTOS_TRACE(TRACE_SEM_UNBLOCK, thread->id);
+}
 
 /*
- * Adds periodic threads to G8RTOS Scheduler
- * Function will initialize a periodic event struct to represent event.
- * The struct will be added to a linked list of periodic events
- * Param Pthread To Add: void-void function for P thread handler
- * Param period: period of P thread to add
- * Returns: Error code for adding threads
+ * Signals the semaphore of every doorbell rung since the last switch
+ *  - Must be called with interrupts disabled, so no ring can come in between reading and clearing the bits
+ *  - A semaphore is not signaled above 1, a consumer woken once drains everything that came in meanwhile
+ *  - Leaves the switch to the caller
+ * Returns: whether a woken thread has a higher priority than the running one
  */
-int G8RTOS_AddPeriodicEvent(void (*PthreadToAdd)(void), uint32_t period)
+static bool ServiceDoorbells(void)
 {
-    //If number of periodic threads is not equal to maximum, then
-    if(NumberOfPthreads != MAXPTHREADS)
+    bool preempt = false;
+    uint32_t rung = RungDoorbells;
+    RungDoorbells = 0;
+
+    while(rung != 0)
     {
-        //If number of periodic threads
-        if(NumberOfPthreads == 0)
-        {
-            //Adds a new periodic thread to point to itself
-            Pthread[NumberOfPthreads].Handler = PthreadToAdd;
-            Pthread[NumberOfPthreads].period = period;
-            Pthread[NumberOfPthreads].currentTime = NumberOfPthreads;
-            Pthread[NumberOfPthreads].executeTime = period + NumberOfPthreads;
-            Pthread[NumberOfPthreads].next = &Pthread[NumberOfPthreads];
-            Pthread[NumberOfPthreads].prev = &Pthread[NumberOfPthreads];
-        }
-        else
+        uint32_t doorbell = __CLZ(rung);
+        rung &= ~(0x80000000 >> doorbell);
+
+        semaphore_t *s = Doorbells[doorbell];
+        if(s->count < 1)
         {
-            //Adds a new periodic thread to point to itself
-            Pthread[NumberOfPthreads].Handler = PthreadToAdd;
-            Pthread[NumberOfPthreads].period = period;
-            Pthread[NumberOfPthreads].currentTime = NumberOfPthreads;
-            Pthread[NumberOfPthreads].executeTime = period + NumberOfPthreads;
-
-            //Makes new periodic thread point to previous and head
-            Pthread[NumberOfPthreads].prev = &Pthread[NumberOfPthreads - 1];
-            Pthread[NumberOfPthreads].next = &Pthread[0];
-
-            //Makes previous root and head point to new periodic thread
-            Pthread[NumberOfPthreads - 1].next = &Pthread[NumberOfPthreads];
-            Pthread[0].prev = &Pthread[NumberOfPthreads];
+            s->count++;
+            if(s->count <= 0)
+            {
+                tcb_t *thread = s->waiters;
+                Wake(thread);
+                preempt |= thread->priority < CurrentlyRunningThread->priority;
+            }
         }
-        NumberOfPthreads++;
-        return SUCCESS;
     }
-    //Returns 0 if more threads cannot be added
-    return ERROR;
+    return preempt;
 }
 
-/* TODO
-    Alternate Sleeping Implementation
-     Another way to implement sleeping is to remove the new sleeping thread from the
-    linked list of active threads, and adding it to new doubly linked list of sleeping threads
-     This new list of sleeping threads will be sorted from smallest to highest sleep count
-     Once the thread with the lowest sleep count equals the system time, that thread is
-    woken up
-     Advantage: Now we only have to check one sleeping threads sleep count within the
-    SysTick handler as opposed to every initialized thread
-*/
+/*
+ * Returns an ended thread's control block to the free list and its stack to the stack arena
+ *  - Thread must not be running on its stack anymore
+ * Param "thread": thread that has ended
+ */
+static void ReleaseThread(tcb_t *thread)
+{
+    FreeStack(thread->stackBase, thread->stackSize);
+
+    //Puts the thread control block back on the free list
+    thread->next = FreeThreads;
+    FreeThreads = thread;
+}
 
 /*
- * Puts the current thread into a sleep state.
- *  param durationMS: Duration of sleep time in ms
+ * Ends a thread
+ *  - Wakes every thread joined on it
+ *  - Thread must already be out of the ready set, sleep list and semaphores
+ *  - Its control block and stack are not given back, see ReleaseThread
+ * Param "thread": thread that has ended
  */
-void G8RTOS_Sleep(uint32_t durationMS)
+static void EndThread(tcb_t *thread)
 {
-    //Initializes currently running threads sleep count
-    CurrentlyRunningThread->sleepCount = SystemTime + durationMS;
+    //Wakes joiners, they only look at the thread's id, which is not changed until the block is reused
+    while(thread->exited.count < 0)
+    {
+        G8RTOS_SignalSemaphore(&thread->exited);
+    }
 
-    //Puts thread to sleep
-    CurrentlyRunningThread->asleep = true;
+    //Mutexes still held go to their next waiters instead of staying locked for good
+    G8RTOS_AbandonMutexes(thread);
 
-    //Sets PendSV flag, to yield CPU
-    SCB->ICSR |= (1<<28);
+    thread->alive = false;
+    thread->asleep = false;
+    thread->blocked = 0;
+    thread->waitingMutex = 0;
+
+    NumberOfThreads--;
+}
+
+#if TICKLESS_IDLE
+/*
+ * Ticks until the next sleeping thread or periodic event is due
+ * Returns: 0 if something is already due, never more than MaxIdleTicks
+ */
+static uint32_t NextWakeupTicks(void)
+{
+    //Longest the idle thread may sleep, cut down by every earlier deadline
+    uint32_t nextWakeup = SystemTime + MaxIdleTicks;
+
+    if(SleepList != 0 && TimeBefore(SleepList->sleepCount, nextWakeup))
+    {
+        nextWakeup = SleepList->sleepCount;
+    }
+
+    if(NumberOfPthreads != 0 && TimeBefore(PeriodicHeap[0]->executeTime, nextWakeup))
+    {
+        nextWakeup = PeriodicHeap[0]->executeTime;
+    }
+
+    //Deadlines that have already passed are due now
+    if(TimeBefore(nextWakeup, SystemTime))
+    {
+        return 0;
+    }
+    return nextWakeup - SystemTime;
+}
+
+/*
+ * Tickless idle
+ *  - Programs SysTick to fire on the tick of the next deadline instead of every tick
+ *  - Sleeps with WFI until an interrupt is pending
+ *  - Adds the ticks that went by to SystemTime and puts SysTick back on its tick grid
+ */
+static void IdleSleep(void)
+{
+    //WFI still wakes up on a pending interrupt, which is only taken once time is corrected
+    int32_t priMask = StartCriticalSection();
+
+    uint32_t idleTicks = NextWakeupTicks();
+
+    //Only worth it if a tick can be skipped, no other thread is ready and no tick is pending
+    if(idleTicks > 1 && ReadyMask == (0x80000000 >> IDLE_PRIORITY) && !(SCB->ICSR & SCB_ICSR_PENDSTSET_Msk))
+    {
+        //Stops SysTick and makes it count through every idle tick
+        SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+        SysTick->LOAD = Tickless_Reload(idleTicks, CyclesPerTick, SysTick->VAL);
+        SysTick->VAL = 0;
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+        __DSB();
+        __WFI();
+        __ISB();
+
+        //Stops SysTick to see how far it got
+        SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+        if(SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
+        {
+            //Whole idle period went by, the pending SysTick adds the last tick
+            G8RTOS_AdvanceTime(idleTicks - 1);
+            SysTick->LOAD = CyclesPerTick - 1;
+        }
+        else
+        {
+            //Woken up early by another interrupt, next tick stays on the tick grid
+            uint32_t count = SysTick->VAL;
+            G8RTOS_AdvanceTime(Tickless_ElapsedTicks(idleTicks, CyclesPerTick, count));
+            SysTick->LOAD = Tickless_CyclesToNextTick(CyclesPerTick, count);
+        }
+
+        //Restarts SysTick, every reload after this one is a single tick again
+        SysTick->VAL = 0;
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        SysTick->LOAD = CyclesPerTick - 1;
+    }
+    else
+    {
+        __WFI();
+    }
+
+    EndCriticalSection(priMask);
+}
+#endif
+
+/*
+ * Moves a periodic event up the heap until its parent releases earlier
+ * Param "index": position of the event in the heap
+ */
+static void HeapSiftUp(uint32_t index)
+{
+    ptcb_t *event = PeriodicHeap[index];
+
+    while(index > 0)
+    {
+        uint32_t parent = (index - 1) / 2;
+        if(!TimeBefore(event->executeTime, PeriodicHeap[parent]->executeTime))
+        {
+            break;
+        }
+        PeriodicHeap[index] = PeriodicHeap[parent];
+        index = parent;
+    }
+    PeriodicHeap[index] = event;
+}
+
+/*
+ * Moves a periodic event down the heap until both children release later
+ * Param "index": position of the event in the heap
+ */
+static void HeapSiftDown(uint32_t index)
+{
+    ptcb_t *event = PeriodicHeap[index];
+
+    while(1)
+    {
+        uint32_t child = 2 * index + 1;
+        if(child >= NumberOfPthreads)
+        {
+            break;
+        }
+
+        //Picks the child that releases first
+        if(child + 1 < NumberOfPthreads && TimeBefore(PeriodicHeap[child + 1]->executeTime, PeriodicHeap[child]->executeTime))
+        {
+            child++;
+        }
+        if(!TimeBefore(PeriodicHeap[child]->executeTime, event->executeTime))
+        {
+            break;
+        }
+        PeriodicHeap[index] = PeriodicHeap[child];
+        index = child;
+    }
+    PeriodicHeap[index] = event;
+}
+
+/*
+ * Runs one release of a periodic event
+ *  - Short handlers run right here in the SysTick handler
+ *  - Deferred handlers are queued for the timer thread, which is all the SysTick handler pays for
+ * Param "event": periodic event being released
+ */
+static void RunPeriodicEvent(ptcb_t *event)
+{
+    G8RTOS_TRACE(TRACE_PERIODIC_RELEASE, event->Handler);
+
+    if(event->context == PERIODIC_SHORT)
+    {
+        uint64_t *previous = ChargeTo(&PeriodicCycles);
+        (*(event->Handler))();
+        (void)ChargeTo(previous);
+        return;
+    }
+
+    //Event joins the back of the timer queue unless it already has a release waiting
+    if(event->pendingReleases++ == 0)
+    {
+        event->nextPending = 0;
+        if(TimerQueueTail != 0)
+        {
+            TimerQueueTail->nextPending = event;
+        }
+        else
+        {
+            TimerQueueHead = event;
+        }
+        TimerQueueTail = event;
+    }
+
+    //Wakes the timer thread
+    G8RTOS_SignalSemaphore(&TimerReleases);
+}
+
+/*
+ * Releases a periodic event that is due
+ *  - Next release time is always a whole number of periods after the first one, so releases never drift
+ *  - Releases missed because the tick ran late are handled by the event's overrun policy
+ * Param "event": periodic event whose release time has been reached
+ */
+static void ReleasePeriodicEvent(ptcb_t *event)
+{
+    //Number of whole periods this release is late by
+    uint32_t late = (SystemTime - event->executeTime) / event->period;
+
+    switch(event->overrun)
+    {
+        case PERIODIC_CATCHUP:
+            //Every release runs, the missed ones back to back until caught up,
+            //each of them is released on its own so each one that is late counts once
+            if(late != 0)
+            {
+                event->missedReleases++;
+            }
+            event->executeTime += event->period;
+            RunPeriodicEvent(event);
+            break;
+
+        case PERIODIC_COALESCE:
+            //Missed releases run once, next release stays on the original grid
+            event->missedReleases += late;
+            event->executeTime += (late + 1) * event->period;
+            RunPeriodicEvent(event);
+            break;
+
+        case PERIODIC_SKIP:
+        default:
+            //Releases a whole period late are dropped, next release stays on the original grid
+            event->missedReleases += late;
+            event->executeTime += (late + 1) * event->period;
+            if(late == 0)
+            {
+                RunPeriodicEvent(event);
+            }
+            break;
+    }
+}
+
+/*
+ * Timer thread
+ * Runs deferred periodic handlers at TIMER_PRIORITY, outside the SysTick handler
+ * Handlers may block, which only delays other deferred handlers
+ */
+static void TimerThread(void)
+{
+    while(1)
+    {
+        //Waits for a release
+        G8RTOS_WaitSemaphore(&TimerReleases);
+
+        //Disables interrupts
+        int32_t priMask = StartCriticalSection();
+
+        //Takes the oldest release, an event with more releases waiting goes to the back
+        ptcb_t *event = TimerQueueHead;
+        TimerQueueHead = event->nextPending;
+        if(TimerQueueHead == 0)
+        {
+            TimerQueueTail = 0;
+        }
+        if(--event->pendingReleases != 0)
+        {
+            event->nextPending = 0;
+            if(TimerQueueTail != 0)
+            {
+                TimerQueueTail->nextPending = event;
+            }
+            else
+            {
+                TimerQueueHead = event;
+            }
+            TimerQueueTail = event;
+        }
+
+        //Enables interrupts
+        EndCriticalSection(priMask);
+
+        //Runs the periodic handler, charged as periodic time rather than to this thread
+        uint64_t *previous = ChargeTo(&PeriodicCycles);
+        (*(event->Handler))();
+        (void)ChargeTo(previous);
+    }
+}
+
+/*
+ * Idle thread
+ * Always ready at the lowest priority so the ready bitmap is never empty
+ * Sleeps the core until the next interrupt instead of spinning
+ */
+static void IdleThread(void)
+{
+    while(1)
+    {
+#if TICKLESS_IDLE
+        IdleSleep();
+#else
+        __WFI();
+#endif
+    }
+}
+
+/*
+ * Chooses the next thread to run.
+ * Priority Scheduling Algorithm:
+ * 	- Highest ready priority found in constant time with CLZ on the ready bitmap
+ * 	- Round Robin among threads of that priority
+ * 	- Blocked and sleeping threads are not in the ready set, so they are never checked
+ */
+void G8RTOS_Scheduler()
+{
+    //Thread that ended itself has been switched out by now, its context was saved before this was called
+    if(ExitedThread != 0)
+    {
+        ReleaseThread(ExitedThread);
+        ExitedThread = 0;
+    }
+
+    //Threads woken by doorbells are ready before choosing, so they run now if they have the highest priority
+    if(RungDoorbells != 0)
+    {
+        (void)ServiceDoorbells();
+    }
+
+    //Highest ready priority, the idle thread keeps the bitmap from being empty
+    uint32_t priority = __CLZ(ReadyMask);
+
+    //If the running thread is at the front of that level, its turn is over
+    if(ReadyList[priority] == CurrentlyRunningThread)
+    {
+        ReadyList[priority] = CurrentlyRunningThread->next;
+    }
+
+    //Runs the thread at the front of the highest ready level
+#if (KERNEL_TRACE == 1)
+    if(ReadyList[priority] != CurrentlyRunningThread)
+    {
+        G8RTOS_TRACE(TRACE_SWITCH, ReadyList[priority]->id);
+    }
+#endif
+    CurrentlyRunningThread = ReadyList[priority];
+
+    //Time up to the switch went to the previous thread, from here on it goes to the new one
+    (void)ChargeTo(&CurrentlyRunningThread->cpuCycles);
+}
+
+
+/*
+ * SysTick Handler
+ * The Systick Handler now will increment the system time,
+ * set the PendSV flag to start the scheduler,
+ * and be responsible for handling sleeping and periodic threads
+ */
+void SysTick_Handler()
+{
+    //Increments system time
+    G8RTOS_AdvanceTime(1);
+
+    //Tick work is charged as ISR time, only once the tick is counted so the time read is right
+    uint64_t *previous = ChargeTo(&IsrCycles);
+    G8RTOS_TRACE(TRACE_ISR_ENTER, SysTick_IRQn + 16);
+
+    //Releases every periodic thread that is due, the earliest release is always at the top of the heap
+    while(NumberOfPthreads != 0 && !TimeBefore(SystemTime, PeriodicHeap[0]->executeTime))
+    {
+        ReleasePeriodicEvent(PeriodicHeap[0]);
+
+        //Release time moved later, so the event moves down to its place
+        HeapSiftDown(0);
+    }
+
+    //Wakes up every thread whose wake time has been reached, the list is sorted so only the front is checked
+    while(SleepList != 0 && !TimeBefore(SystemTime, SleepList->sleepCount))
+    {
+        tcb_t *temp = SleepList;
+        SleepRemove(temp);
+
+        //Thread woken up and sleep count made 0
+        temp->asleep = false;
+        temp->sleepCount = 0;
+
+        //Timed wait ran out, so the thread leaves the wait queue and gives back the count it took
+        if(temp->blocked)
+        {
+            WaitRemove(temp);
+            temp->blocked->count++;
+            temp->blocked = 0;
+            temp->timedOut = true;
+        }
+
+        //Thread goes back into the ready set
+        G8RTOS_AddReady(temp);
+    }
+
+    G8RTOS_TRACE(TRACE_ISR_EXIT, SysTick_IRQn + 16);
+    (void)ChargeTo(previous);
+
+    //Sets PendSV flag
+    G8RTOS_PendSV();
+}
+
+/*********************************************** Private Functions ********************************************************************/
+
+
+/*********************************************** Public Variables *********************************************************************/
+
+/* Holds the current time for the whole System, in ticks */
+uint32_t SystemTime;
+
+/*********************************************** Public Variables *********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Sets variables to an initial state (system time and number of threads)
+ * Enables board for highest speed clock and disables watchdog
+ */
+void G8RTOS_Init()
+{
+    //Sets system time to 0
+    SystemTime = 0;
+
+    //Sets number of threads to 0
+    NumberOfThreads = 0;
+
+    //Sets number of periodic threads to 0
+    NumberOfPthreads = 0;
+
+    //No thread is ready or asleep yet
+    ReadyMask = 0;
+    SleepList = 0;
+
+    //No deferred periodic release is waiting
+    TimerQueueHead = 0;
+    TimerQueueTail = 0;
+    G8RTOS_InitSemaphore(&TimerReleases, 0, SEMAPHORE_FIFO);
+
+    //Back channel UART is shared by the trace thread and the application
+    G8RTOS_InitMutex(&G8RTOS_BackChannelMutex, MUTEX_NO_CEILING);
+
+    //Whole stack arena is free
+    StackArenaTop = 0;
+    FreeStacks = 0;
+
+    //Every thread control block starts on the free list
+    FreeThreads = 0;
+    for(int32_t i = MAX_THREADS - 1; i >= 0; --i)
+    {
+        threadControlBlocks[i].alive = false;
+        threadControlBlocks[i].next = FreeThreads;
+        FreeThreads = &threadControlBlocks[i];
+    }
+    ExitedThread = 0;
+    NextThreadSerial = 0;
+    Launched = false;
+
+    //No periodic or interrupt time yet
+    PeriodicCycles = 0;
+    IsrCycles = 0;
+#if (CPU_ACCOUNTING == 1)
+    //Nothing is charged until launch
+    ChargedCycles = 0;
+#endif
+
+    //Initializes board
+    BSP_InitBoard();
+}
+
+/*
+ * Starts G8RTOS Scheduler
+ * 	- Initializes the Systick
+ * 	- Sets Context to first thread
+ * Returns: Error Code for starting scheduler. This will only return if the scheduler fails
+ */
+int G8RTOS_Launch()
+{
+    //Adds the idle thread so there is always a thread to run
+    IdleThreadId = G8RTOS_AddThread(&IdleThread, IDLE_PRIORITY, IDLE_STACKSIZE);
+    if(IdleThreadId == ERROR)
+    {
+        return ERROR;
+    }
+
+    //Adds the timer thread that runs deferred periodic handlers
+    if(G8RTOS_AddThread(&TimerThread, TIMER_PRIORITY, TIMER_STACKSIZE) == ERROR)
+    {
+        return ERROR;
+    }
+
+#if (KERNEL_TRACE == 1)
+    //Adds the trace thread that sends recorded events to the host
+    if(G8RTOS_AddThread(&G8RTOS_TraceThread, TRACE_PRIORITY, TRACE_STACKSIZE) == ERROR)
+    {
+        return ERROR;
+    }
+#endif
+
+    //Sets currently running thread to the front of the highest ready priority
+    CurrentlyRunningThread = ReadyList[__CLZ(ReadyMask)];
+
+    //Gets clock frequency
+    uint32_t clkFreq = ClockSys_GetSysFreq();
+
+    //Initializes the time base and SysTick
+    CyclesPerTick = G8RTOS_InitTime(clkFreq);
+    MaxIdleTicks = Tickless_MaxIdleTicks(CyclesPerTick, SysTick_LOAD_RELOAD_Msk);
+    InitSysTick(CyclesPerTick);
+
+#if (CPU_ACCOUNTING == 1)
+    //First thread is charged from here, the first load window starts here too
+    ChargeStart = G8RTOS_GetTimeCycles();
+    ChargedCycles = &CurrentlyRunningThread->cpuCycles;
+    SnapshotTime = ChargeStart;
+    SnapshotPeriodicCycles = 0;
+    SnapshotIsrCycles = 0;
+#endif
+
+    //Sets priorities for PENDSV and SysTick
+    NVIC_SetPriority(PendSV_IRQn, 7);
+
+#if (__FPU_USED == 1)
+    //Threads that use the FPU get an FP frame, S0-S15 are only stacked if the handler uses the FPU
+    FPU->FPCCR |= FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk;
+#endif
+
+    //Call G8RTOS_Start
+    Launched = true;
+    G8RTOS_Start();
+
+    return ERROR;
+}
+
+
+/*
+ * Adds threads to G8RTOS Scheduler, before or after launch
+ * 	- Takes a free thread control block from the free list
+ * 	- Takes a stack of the requested size from the stack arena
+ * 	- Initializes the thread control block for the provided thread
+ * 	- Initializes the stack for the provided thread to hold a "fake context"
+ * 	- Sets the fake LR to G8RTOS_ExitThread so the thread can return
+ * 	- Puts the thread in the ready list of its priority level
+ * Param "threadToAdd": Void-Void Function to add as preemptable main thread
+ * Param "priority": 0 (highest) to IDLE_PRIORITY (lowest)
+ * Param "stackSize": stack size in bytes, at least MIN_STACKSIZE, rounded up to a multiple of 8
+ * Returns: Id of the new thread, or ERROR if no thread control block or stack space is free
+ * THIS IS A CRITICAL SECTION
+ */
+int G8RTOS_AddThread(void (*threadToAdd)(void), uint8_t priority, uint32_t stackSize)
+{
+    //Rounds size up so the top of the stack stays 8 byte aligned
+    stackSize = (stackSize + STACK_ALIGNMENT - 1) & ~(STACK_ALIGNMENT - 1);
+
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    //If a thread control block is free and priority and stack size are valid
+    if(FreeThreads == 0 || priority >= NUM_PRIORITIES || stackSize < MIN_STACKSIZE)
+    {
+        EndCriticalSection(priMask);
+        return ERROR;
+    }
+
+    //Takes a stack from the arena
+    int32_t *stack = AllocateStack(&stackSize);
+    if(stack == 0)
+    {
+        EndCriticalSection(priMask);
+        return ERROR;
+    }
+
+    //Takes thread control block from the free list
+    tcb_t *thread = FreeThreads;
+    FreeThreads = thread->next;
+    uint32_t index = thread - threadControlBlocks;
+
+    //Gives the thread a new id, old ids of this block no longer match
+    NextThreadSerial++;
+    threadId_t threadId = ((NextThreadSerial & THREADID_SERIAL_MASK) << THREADID_SHIFT) | index;
+    thread->id = threadId;
+    thread->alive = true;
+
+    //Sets priority of thread, it only runs above it while holding a mutex
+    thread->priority = priority;
+    thread->basePriority = priority;
+    thread->heldMutexes = 0;
+    thread->waitingMutex = 0;
+
+    //Makes thread start awake
+    thread->asleep = 0;
+
+    //Makes thread sleep count equal 0
+    thread->sleepCount = 0;
+
+    //Makes blocked semaphore 0
+    thread->blocked = 0;
+    thread->timedOut = false;
+
+    //No thread is waiting for this one to end
+    G8RTOS_InitSemaphore(&thread->exited, 0, SEMAPHORE_FIFO);
+
+    //Remembers the stack so it can be given back
+    thread->stackBase = stack;
+    thread->stackSize = stackSize;
+    thread->cpuCycles = 0;
+    thread->snapshotCycles = 0;
+    int32_t *stackTop = stack + stackSize / sizeof(int32_t);
+
+    //First context starts the thread function, returning from it ends the thread
+    G8RTOS_PortInitContext(thread, stackTop, threadToAdd, &G8RTOS_ExitThread);
+
+    //Thread starts in the ready set
+    G8RTOS_AddReady(thread);
+
+    //Increments number of threads
+    NumberOfThreads++;
+
+    //A new thread with a higher priority than the running one takes over right away
+    if(Launched && priority < CurrentlyRunningThread->priority)
+    {
+        G8RTOS_PendSV();
+    }
+
+    EndCriticalSection(priMask);
+    return threadId;
+}
+
+/*
+ * Ends the currently running thread
+ *  - Also reached when a thread function returns
+ *  - Wakes every thread waiting in G8RTOS_JoinThread
+ *  - Its thread control block and stack go back to the free list once it has been switched out
+ * THIS IS A CRITICAL SECTION
+ */
+void G8RTOS_ExitThread(void)
+{
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    G8RTOS_RemoveReady(CurrentlyRunningThread);
+    EndThread(CurrentlyRunningThread);
+
+    //Still running on its stack, so the block and stack are given back by the scheduler once it is switched out,
+    //an interrupt adding a thread before then cannot be handed them
+    ExitedThread = CurrentlyRunningThread;
+
+    //Sets PendSV flag, this thread never runs again
+    G8RTOS_PendSV();
+
+    //Enables interrupts, which lets the context switch happen
+    EndCriticalSection(priMask);
+
+    while(1);
+}
+
+/*
+ * Ends any thread
+ *  - Takes it out of the ready set, the sleep list or the semaphore it is blocked on
+ *  - Its thread control block and stack go back to the free list
+ * Param "threadId": Id returned by G8RTOS_AddThread
+ * Returns: Error code if the thread does not exist or is the idle thread
+ * THIS IS A CRITICAL SECTION
+ */
+int32_t G8RTOS_KillThread(threadId_t threadId)
+{
+    //Killing itself is the same as exiting
+    if(threadId == CurrentlyRunningThread->id)
+    {
+        G8RTOS_ExitThread();
+    }
+
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    tcb_t *thread = FindThread(threadId);
+
+    //Idle thread has to stay ready
+    if(thread == 0 || thread->id == IdleThreadId)
+    {
+        EndCriticalSection(priMask);
+        return ERROR;
+    }
+
+    //Takes thread out of whatever it is waiting in, a timed wait is in both the sleep list and a wait queue
+    if(thread->blocked)
+    {
+        //Gives back the count the thread took when it blocked
+        WaitRemove(thread);
+        thread->blocked->count++;
+
+        //A FIFO waiter at the front may have been holding back the ones behind it
+        G8RTOS_AbandonFIFOWait(thread->blocked);
+
+        //Owners it was lending its priority to drop back
+        if(thread->waitingMutex)
+        {
+            G8RTOS_AbandonMutexWait(thread);
+        }
+    }
+    if(thread->asleep)
+    {
+        SleepRemove(thread);
+    }
+    if(!thread->blocked && !thread->asleep)
+    {
+        G8RTOS_RemoveReady(thread);
+    }
+
+    //Not running, so its block and stack can be reused right away
+    EndThread(thread);
+    ReleaseThread(thread);
+
+    //A woken joiner may have a higher priority
+    G8RTOS_PendSV();
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+    return SUCCESS;
+}
+
+/*
+ * Waits until a thread has ended
+ * Param "threadId": Id returned by G8RTOS_AddThread
+ * Returns: SUCCESS once the thread has ended (right away if it already has),
+ *          ERROR if a thread tries to join itself
+ * THIS IS A CRITICAL SECTION
+ */
+int32_t G8RTOS_JoinThread(threadId_t threadId)
+{
+    if(threadId == CurrentlyRunningThread->id)
+    {
+        return ERROR;
+    }
+
+    //Disables interrupts so the thread cannot end between the check and the wait
+    int32_t priMask = StartCriticalSection();
+
+    tcb_t *thread = FindThread(threadId);
+    if(thread != 0)
+    {
+        //Blocks until the thread signals it has ended, switch happens once interrupts are enabled
+        G8RTOS_WaitSemaphore(&thread->exited);
+    }
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+    return SUCCESS;
+}
+
+/*
+ * Returns: Id of the currently running thread
+ */
+threadId_t G8RTOS_GetThreadId(void)
+{
+    return CurrentlyRunningThread->id;
+}
+
+/*
+ * Takes a CPU load snapshot over the window since the previous snapshot, or since launch
+ *  - Starts a new window, so every caller shares the same windows
+ * Param "load": filled in with the load of every thread, periodic handlers, interrupts and idle
+ * Returns: ERROR if CPU_ACCOUNTING is off or the window is empty
+ * THIS IS A CRITICAL SECTION
+ */
+int32_t G8RTOS_GetCpuLoad(cpuLoad_t *load)
+{
+#if (CPU_ACCOUNTING == 1)
+    //Disables interrupts so every counter is read at the same time
+    int32_t priMask = StartCriticalSection();
+
+    //Brings the running thread's counter up to now
+    (void)ChargeTo(ChargedCycles);
+
+    uint64_t window = ChargeStart - SnapshotTime;
+    if(!Launched || window == 0)
+    {
+        EndCriticalSection(priMask);
+        return ERROR;
+    }
+    SnapshotTime = ChargeStart;
+    load->windowCycles = window;
+
+    load->numberOfThreads = 0;
+    load->idleLoad = 0;
+    for(uint32_t i = 0; i < MAX_THREADS; i++)
+    {
+        tcb_t *thread = &threadControlBlocks[i];
+        if(!thread->alive)
+        {
+            continue;
+        }
+
+        threadLoad_t *entry = &load->threads[load->numberOfThreads++];
+        entry->id = thread->id;
+        entry->priority = thread->priority;
+        entry->cycles = thread->cpuCycles - thread->snapshotCycles;
+        entry->load = Load(entry->cycles, window);
+        thread->snapshotCycles = thread->cpuCycles;
+
+        if(thread->id == IdleThreadId)
+        {
+            load->idleLoad = entry->load;
+        }
+    }
+
+    load->periodicLoad = Load(PeriodicCycles - SnapshotPeriodicCycles, window);
+    SnapshotPeriodicCycles = PeriodicCycles;
+    load->isrLoad = Load(IsrCycles - SnapshotIsrCycles, window);
+    SnapshotIsrCycles = IsrCycles;
+    load->systemLoad = 10000 - load->idleLoad;
+
+    EndCriticalSection(priMask);
+    return SUCCESS;
+#else
+    return ERROR;
+#endif
+}
+
+/*
+ * Charges an interrupt handler's cycles to ISR time instead of the thread it interrupted
+ *  - Call first thing in the handler and pass the result to G8RTOS_ExitISR before returning
+ * Returns: what was being charged before the interrupt
+ */
+void *G8RTOS_EnterISR(void)
+{
+    G8RTOS_TRACE(TRACE_ISR_ENTER, SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk);
+#if (CPU_ACCOUNTING == 1)
+    return ChargeTo(&IsrCycles);
+#else
+    return 0;
+#endif
+}
+
+/*
+ * Ends an interrupt handler started with G8RTOS_EnterISR
+ * Param "previous": value returned by G8RTOS_EnterISR
+ */
+void G8RTOS_ExitISR(void *previous)
+{
+    G8RTOS_TRACE(TRACE_ISR_EXIT, SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk);
+    (void)ChargeTo((uint64_t *)previous);
+}
+
+
+/*
+ * Adds periodic threads to G8RTOS Scheduler, before or after launch
+ * Function will initialize a periodic event struct to represent event.
+ * The struct will be added to the min heap of periodic events, keyed by release time
+ * Param Pthread To Add: void-void function for P thread handler
+ * Param period: period of P thread to add, in ms
+ * Param overrun: what happens to releases that were missed because the tick ran late
+ * Param context: PERIODIC_DEFERRED runs the handler in the timer thread, PERIODIC_SHORT in the SysTick handler
+ * Returns: Error code for adding threads
+ * THIS IS A CRITICAL SECTION
+ */
+int G8RTOS_AddPeriodicEvent(void (*PthreadToAdd)(void), uint32_t period, periodicOverrun_t overrun, periodicContext_t context)
+{
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    //If number of periodic threads is not equal to maximum, then
+    if(NumberOfPthreads != MAXPTHREADS && period != 0)
+    {
+        ptcb_t *event = &Pthread[NumberOfPthreads];
+        period = G8RTOS_MsToTicks(period);
+
+        //Initializes periodic thread, offset by its index so events with the same period do not release on the same tick
+        event->Handler = PthreadToAdd;
+        event->period = period;
+        event->currentTime = NumberOfPthreads;
+        event->executeTime = SystemTime + period + NumberOfPthreads;
+        event->overrun = overrun;
+        event->missedReleases = 0;
+        event->context = context;
+        event->pendingReleases = 0;
+        event->nextPending = 0;
+
+        //Puts it at the bottom of the heap and moves it up to its place
+        PeriodicHeap[NumberOfPthreads] = event;
+        HeapSiftUp(NumberOfPthreads);
+
+        NumberOfPthreads++;
+
+        EndCriticalSection(priMask);
+        return SUCCESS;
+    }
+
+    //Returns error if more threads cannot be added
+    EndCriticalSection(priMask);
+    return ERROR;
+}
+
+/*
+ * Returns: Releases of a periodic event that were late by at least a whole period, 0 if there is no such event
+ * Param "handler": handler the event was added with
+ */
+uint32_t G8RTOS_GetMissedReleases(void (*handler)(void))
+{
+    for(uint32_t i = 0; i < NumberOfPthreads; i++)
+    {
+        if(Pthread[i].Handler == handler)
+        {
+            return Pthread[i].missedReleases;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Puts the current thread into a sleep state.
+ *  - Moves the thread from the ready set to the sorted sleep list
+ *  param durationMS: Duration of sleep time in ms, must be below 2^31
+ */
+void G8RTOS_Sleep(uint32_t durationMS)
+{
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    //Initializes currently running threads sleep count
+    CurrentlyRunningThread->sleepCount = SystemTime + G8RTOS_MsToTicks(durationMS);
+
+    //Puts thread to sleep
+    CurrentlyRunningThread->asleep = true;
+
+    //Sleeping thread leaves the ready set for the sleep list
+    G8RTOS_RemoveReady(CurrentlyRunningThread);
+    SleepInsert(CurrentlyRunningThread);
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+
+    //Sets PendSV flag, to yield CPU
+    G8RTOS_PendSV();
+}
+
+/*
+ * Returns: Bytes of the stack arena that no thread is using
+ * THIS IS A CRITICAL SECTION
+ */
+uint32_t G8RTOS_GetUnusedStackArena(void)
+{
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    //Never carved part plus every stack that was given back
+    uint32_t unused = STACK_ARENA_SIZE - StackArenaTop;
+    for(freeStack_t *block = FreeStacks; block != 0; block = block->next)
+    {
+        unused += block->size;
+    }
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+    return unused;
+}
+
+/*
+ * Adds a doorbell, through which a producer that cannot touch a semaphore has it signaled
+ *  - Adding a semaphore that already has a doorbell gives back that doorbell
+ * Param "s": semaphore the doorbell signals, it is never signaled above 1
+ * Returns: doorbell for G8RTOS_RingDoorbell, or ERROR if MAX_DOORBELLS have been added
+ * THIS IS A CRITICAL SECTION
+ */
+int32_t G8RTOS_AddDoorbell(semaphore_t *s)
+{
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    uint32_t doorbell;
+    for(doorbell = 0; doorbell < NumberOfDoorbells; doorbell++)
+    {
+        if(Doorbells[doorbell] == s)
+        {
+            EndCriticalSection(priMask);
+            return doorbell;
+        }
+    }
+
+    if(NumberOfDoorbells == MAX_DOORBELLS)
+    {
+        EndCriticalSection(priMask);
+        return ERROR;
+    }
+    Doorbells[NumberOfDoorbells++] = s;
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+    return doorbell;
+}
+
+/*
+ * Rings a doorbell, may be called from any interrupt
+ *  - In an interrupt it never disables interrupts, the doorbell's bit is set with an exclusive load and store
+ *    and its semaphore is signaled by the scheduler on the switch this requests
+ *  - A thread signals the semaphore right away and only switches if the woken thread has a higher priority
+ * Param "doorbell": doorbell from G8RTOS_AddDoorbell
+ */
+void G8RTOS_RingDoorbell(int32_t doorbell)
+{
+    uint32_t rung;
+
+    //Tried again if an interrupt rang a doorbell in between
+    do
+    {
+        rung = __LDREXW(&RungDoorbells);
+    }while(__STREXW(rung | (0x80000000 >> doorbell), &RungDoorbells));
+
+    //In an interrupt, sets PendSV flag, the scheduler signals the semaphore
+    if(SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk)
+    {
+        G8RTOS_PendSV();
+        return;
+    }
+
+    //A thread does not give up the rest of its turn to an equal priority reader, like G8RTOS_SignalSemaphore
+    int32_t priMask = StartCriticalSection();
+    bool preempt = ServiceDoorbells();
+    EndCriticalSection(priMask);
+
+    if(preempt)
+    {
+        G8RTOS_PendSV();
+    }
 }
 
 /*********************************************** Public Functions *********************************************************************/
+
+
+/*********************************************** Port Functions ***********************************************************************/
+
+#ifndef G8RTOS_HOST
+/*
+ * Builds the first context of a new thread, so the first switch to it starts "entry"
+ *  - A fake exception frame under the context PendSV saves: R4-R11 and EXC_RETURN, then R0-R3, R12, LR, PC, xPSR
+ * Param "thread": thread control block of the new thread, its sp is set here
+ * Param "stackTop": one past the highest word of the thread's stack
+ * Param "entry": thread function
+ * Param "exit": function the thread ends in if "entry" returns
+ */
+void G8RTOS_PortInitContext(tcb_t *thread, int32_t *stackTop, void (*entry)(void), void (*exit)(void))
+{
+    //Sets thumbbit in xPSR
+    stackTop[-1] = THUMBBIT;
+
+    //Sets PC to function pointer
+    stackTop[-2] = (uint32_t)entry;
+
+    //Fills R0 to R14 with dummy values
+    for (uint8_t i = 3; i <= FAKE_CONTEXT_WORDS; i++)
+        stackTop[-i] = 1;
+
+    //Sets LR so returning from the thread ends it
+    stackTop[-3] = (uint32_t)exit;
+
+    //Sets EXC_RETURN saved by PendSV, a new thread has not used the FPU
+    stackTop[-9] = EXC_RETURN_THREAD_PSP;
+
+    //Sets stack pointer to point to top of stack pointer address
+    thread->sp = &stackTop[-FAKE_CONTEXT_WORDS];
+}
+#endif
+
+/*********************************************** Port Functions ***********************************************************************/
+
+
+/*********************************************** Kernel Functions *********************************************************************/
+
+/*
+ * Puts a thread at the back of the ready list of its priority level
+ * Param "thread": thread that is no longer blocked or asleep
+ */
+void G8RTOS_AddReady(tcb_t *thread)
+{
+    tcb_t *head = ReadyList[thread->priority];
+
+    //If level is empty, thread points to itself and level is marked ready
+    if(head == 0)
+    {
+        thread->next = thread;
+        thread->prev = thread;
+        ReadyList[thread->priority] = thread;
+        ReadyMask |= (0x80000000 >> thread->priority);
+    }
+    else
+    {
+        //Inserts thread before the head, which is the back of the list
+        thread->next = head;
+        thread->prev = head->prev;
+        head->prev->next = thread;
+        head->prev = thread;
+    }
+}
+
+/*
+ * Takes a thread out of the ready set so the scheduler never looks at it
+ * Param "thread": thread that is about to block or sleep
+ */
+void G8RTOS_RemoveReady(tcb_t *thread)
+{
+    //If thread is the only one at its level, level is no longer ready
+    if(thread->next == thread)
+    {
+        ReadyList[thread->priority] = 0;
+        ReadyMask &= ~(0x80000000 >> thread->priority);
+    }
+    else
+    {
+        //Unlinks thread from its neighbours
+        thread->prev->next = thread->next;
+        thread->next->prev = thread->prev;
+
+        //If thread was at the front, the one behind it moves up
+        if(ReadyList[thread->priority] == thread)
+        {
+            ReadyList[thread->priority] = thread->next;
+        }
+    }
+}
+
+/*
+ * Moves the running thread from the ready set to a semaphore's wait queue
+ *  - Constant time for a FIFO semaphore
+ *  - For a priority semaphore, walks back past the waiters of lower priority, so at most MAX_THREADS steps
+ *  - A timed wait also goes in the sleep list, the tick that wakes it takes it off the queue and sets timedOut
+ * Param "s": semaphore the thread blocks on
+ * Param "timeoutTicks": ticks until the wait times out, or WAIT_FOREVER
+ */
+void G8RTOS_BlockThread(semaphore_t *s, uint32_t timeoutTicks)
+{
+    tcb_t *thread = CurrentlyRunningThread;
+
+    G8RTOS_RemoveReady(thread);
+    thread->blocked = s;
+    thread->timedOut = false;
+    WaitInsert(s, thread);
+
+    //Timeout is a sleep that the signal cuts short
+    if(timeoutTicks != WAIT_FOREVER)
+    {
+        thread->sleepCount = SystemTime + timeoutTicks;
+        thread->asleep = true;
+        SleepInsert(thread);
+    }
+}
+
+/*
+ * Changes the priority a thread runs at, wherever it is waiting
+ *  - A ready thread moves to the back of its new level
+ *  - A thread blocked on a priority semaphore moves to its new place in the wait queue
+ *  - Does not request a context switch, the caller does if the running thread may no longer be the highest
+ * Param "thread": thread to change
+ * Param "priority": new priority, 0 (highest) to IDLE_PRIORITY (lowest)
+ */
+void G8RTOS_SetPriority(tcb_t *thread, uint8_t priority)
+{
+    if(thread->priority == priority)
+    {
+        return;
+    }
+
+    if(thread->blocked)
+    {
+        semaphore_t *s = thread->blocked;
+        if(s->order == SEMAPHORE_PRIORITY)
+        {
+            WaitRemove(thread);
+            thread->priority = priority;
+            WaitInsert(s, thread);
+        }
+        else
+        {
+            thread->priority = priority;
+        }
+    }
+    else if(thread->asleep)
+    {
+        thread->priority = priority;
+    }
+    else
+    {
+        G8RTOS_RemoveReady(thread);
+        thread->priority = priority;
+        G8RTOS_AddReady(thread);
+    }
+}
+
+/*
+ * Unblocks the first thread in a semaphore's wait queue, in constant time
+ *  - Takes it out of the sleep list too if it was a timed wait
+ *  - Requests a context switch if that thread has a higher priority than the running one
+ * Param "s": semaphore that was signaled
+ */
+void G8RTOS_UnblockThread(semaphore_t *s)
+{
+    if(s->waiters != 0)
+    {
+        G8RTOS_UnblockWaiter(s->waiters);
+    }
+}
+
+/*
+ * Unblocks a given thread from anywhere in the wait queue it is in, in constant time
+ *  - Takes it out of the sleep list too if it was a timed wait
+ *  - Requests a context switch if that thread has a higher priority than the running one
+ *  - Leaves the count of the semaphore to the caller
+ * Param "thread": thread that is blocked
+ */
+void G8RTOS_UnblockWaiter(tcb_t *thread)
+{
+    Wake(thread);
+
+    //Woken thread should not have to wait for the next tick to preempt
+    if(thread->priority < CurrentlyRunningThread->priority)
+    {
+        G8RTOS_PendSV();
+    }
+}
+
+/*********************************************** Kernel Functions *********************************************************************/
@@ -5,16 +5,120 @@
 #ifndef G8RTOS_SCHEDULER_H_
 #define G8RTOS_SCHEDULER_H_
 
+#include "G8RTOS_Semaphores.h"
+
+/* Thread Control Block, defined in G8RTOS_Structures.h */
+struct tcb_t;
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+/*
+ * Thread id, stays unique after the thread control block is reused
+ */
+typedef int32_t threadId_t;
+
+/*
+ * What a periodic event does with releases it missed because the tick ran late
+ *  - PERIODIC_SKIP: missed releases are dropped, the next release stays on the original grid
+ *  - PERIODIC_CATCHUP: every missed release runs, back to back
+ *  - PERIODIC_COALESCE: missed releases run once, the next release stays on the original grid
+ */
+typedef enum
+{
+    PERIODIC_SKIP,
+    PERIODIC_CATCHUP,
+    PERIODIC_COALESCE
+}periodicOverrun_t;
+
+/*
+ * Where a periodic handler runs
+ *  - PERIODIC_DEFERRED: in the kernel timer thread at TIMER_PRIORITY, the handler may block
+ *  - PERIODIC_SHORT: inside the SysTick handler, for a few cycles of work that never blocks
+ */
+typedef enum
+{
+    PERIODIC_DEFERRED,
+    PERIODIC_SHORT
+}periodicContext_t;
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
 /*********************************************** Sizes and Limits *********************************************************************/
-#define MAX_THREADS 6
+#ifndef MAX_THREADS
+#define MAX_THREADS (8 + KERNEL_TRACE) //Includes the kernel idle and timer threads, and the trace thread when tracing
+#endif
 #define MAXPTHREADS 6
-#define STACKSIZE 1024
+#ifndef STACK_ARENA_SIZE
+#define STACK_ARENA_SIZE (5120 + KERNEL_TRACE * TRACE_STACKSIZE) //Bytes shared by every thread stack, interrupts use the main stack (linker --stack_size)
+#endif
+#define MIN_STACKSIZE 128 //Smallest stack in bytes, holds the initial context with room to spare
+#define IDLE_STACKSIZE 256 //Stack in bytes of the kernel idle thread
 #define OSINT_PRIORITY 7
+#define NUM_PRIORITIES 32 //One bit per priority level in the ready bitmap
+#define IDLE_PRIORITY (NUM_PRIORITIES - 1) //Lowest priority, used by the kernel idle thread
+#define TIMER_PRIORITY 0 //Highest priority, used by the kernel timer thread that runs deferred periodic handlers
+#define TIMER_STACKSIZE 1024 //Stack in bytes of the kernel timer thread, deferred periodic handlers run on it
+#define TRACE_PRIORITY (IDLE_PRIORITY - 1) //Used by the kernel trace thread, below every thread that records events
+#define TRACE_STACKSIZE 768 //Stack in bytes of the kernel trace thread, holds one batch of records
 /*********************************************** Sizes and Limits *********************************************************************/
 
+/*********************************************** Configuration ************************************************************************/
+
+/* When 1 the idle thread skips ticks until the next sleeping thread or periodic event is due, only simulated on the host */
+#ifndef TICKLESS_IDLE
+#if defined(G8RTOS_HOST) && !defined(G8RTOS_SIM)
+#define TICKLESS_IDLE 0
+#else
+#define TICKLESS_IDLE 1
+#endif
+#endif
+
+/* When 1 every context switch, interrupt and periodic handler charges its cycles for G8RTOS_GetCpuLoad */
+#ifndef CPU_ACCOUNTING
+#define CPU_ACCOUNTING 1
+#endif
+
+/* When 1 kernel events are recorded in a RAM ring and sent over the back channel UART, see G8RTOS_Trace.h */
+#ifndef KERNEL_TRACE
+#define KERNEL_TRACE 0
+#endif
+
+/*********************************************** Configuration ************************************************************************/
+
+/*********************************************** CPU Load *****************************************************************************/
+
+/*
+ * CPU load of one thread over a snapshot window
+ */
+typedef struct
+{
+    threadId_t id;
+    uint8_t priority;
+    uint64_t cycles; //Cycles the thread ran in the window
+    uint32_t load; //Share of the window in hundredths of a percent
+}threadLoad_t;
+
+/*
+ * CPU load over the window since the previous snapshot, loads are in hundredths of a percent
+ *  - Periodic handlers and interrupts are not charged to the thread they interrupted
+ *  - Idle time includes the time the core slept
+ */
+typedef struct
+{
+    uint64_t windowCycles; //Length of the window in cycles
+    uint32_t numberOfThreads; //Entries used in threads
+    threadLoad_t threads[MAX_THREADS]; //Every live thread, idle and timer threads included
+    uint32_t periodicLoad; //Periodic handlers, in the SysTick handler or the timer thread
+    uint32_t isrLoad; //SysTick and interrupt handlers that use G8RTOS_EnterISR
+    uint32_t idleLoad; //Idle thread
+    uint32_t systemLoad; //Everything but the idle thread
+}cpuLoad_t;
+
+/*********************************************** CPU Load *****************************************************************************/
+
 /*********************************************** Public Variables *********************************************************************/
 
-/* Holds the current time for the whole System */
+/* Holds the current time for the whole System, in ticks of G8RTOS_TICK_HZ */
 extern uint32_t SystemTime;
 
 /*********************************************** Public Variables *********************************************************************/
@@ -36,26 +140,108 @@ void G8RTOS_Init();
 int32_t G8RTOS_Launch();
 
 /*
- * Adds threads to G8RTOS Scheduler
- * 	- Checks if there are stil available threads to insert to scheduler
+ * Adds threads to G8RTOS Scheduler, before or after launch
+ * 	- Takes a free thread control block from the free list
+ * 	- Takes a stack of the requested size from the stack arena
  * 	- Initializes the thread control block for the provided thread
  * 	- Initializes the stack for the provided thread
- * 	- Sets up the next and previous tcb pointers in a round robin fashion
- * Param "threadToAdd": Void-Void Function to add as preemptable main thread
- * Returns: Error code for adding threads
+ * 	- Puts the thread in the ready list of its priority level
+ * Param "threadToAdd": Void-Void Function to add as preemptable main thread, may return to end the thread
+ * Param "priority": 0 (highest) to IDLE_PRIORITY (lowest), equal priorities share the CPU round robin
+ * Param "stackSize": stack size in bytes, at least MIN_STACKSIZE
+ *                    threads that use the FPU need 136 more bytes for S0-S31 and FPSCR when switched out
+ * Returns: Id of the new thread, or ERROR if MAX_THREADS are alive or the stack arena is full
+ */
+int32_t G8RTOS_AddThread(void (*threadToAdd)(void), uint8_t priority, uint32_t stackSize);
+
+/*
+ * Ends the currently running thread, same as returning from the thread function
+ *  - Wakes every thread waiting in G8RTOS_JoinThread
+ *  - Its thread control block and stack go back to the free list
+ */
+void G8RTOS_ExitThread(void);
+
+/*
+ * Ends any thread other than the idle thread
+ * Param "threadId": Id returned by G8RTOS_AddThread
+ * Returns: Error code if the thread does not exist
+ */
+int32_t G8RTOS_KillThread(threadId_t threadId);
+
+/*
+ * Waits until a thread has ended
+ * Param "threadId": Id returned by G8RTOS_AddThread
+ * Returns: SUCCESS once the thread has ended, ERROR if a thread tries to join itself
+ */
+int32_t G8RTOS_JoinThread(threadId_t threadId);
+
+/*
+ * Returns: Id of the currently running thread
+ */
+threadId_t G8RTOS_GetThreadId(void);
+
+/*
+ * Takes a CPU load snapshot over the window since the previous snapshot, or since launch
+ *  - Starts a new window, so every caller shares the same windows
+ * Param "load": filled in with the load of every thread, periodic handlers, interrupts and idle
+ * Returns: ERROR if CPU_ACCOUNTING is off or the window is empty
  */
-int32_t G8RTOS_AddThread(void (*threadToAdd)(void));
+int32_t G8RTOS_GetCpuLoad(cpuLoad_t *load);
 
+/*
+ * Charges an interrupt handler's cycles to ISR time instead of the thread it interrupted
+ *  - Call first thing in the handler and pass the result to G8RTOS_ExitISR before returning
+ * Returns: what was being charged before the interrupt
+ */
+void *G8RTOS_EnterISR(void);
+
+/*
+ * Ends an interrupt handler started with G8RTOS_EnterISR
+ * Param "previous": value returned by G8RTOS_EnterISR
+ */
+void G8RTOS_ExitISR(void *previous);
+
+/*
+ * Returns: Bytes of the stack arena that no thread is using
+ */
+uint32_t G8RTOS_GetUnusedStackArena(void);
+
+/*
+ * Adds a doorbell, through which a producer that cannot touch a semaphore has it signaled
+ *  - Adding a semaphore that already has a doorbell gives back that doorbell
+ * Param "s": semaphore the doorbell signals, it is never signaled above 1
+ * Returns: doorbell for G8RTOS_RingDoorbell, or ERROR if all of them have been added
+ */
+int32_t G8RTOS_AddDoorbell(semaphore_t *s);
 
 /*
- * Adds periodic threads to G8RTOS Scheduler
+ * Rings a doorbell, may be called from any interrupt
+ *  - In an interrupt it never disables interrupts, the doorbell's bit is set with an exclusive load and store
+ *    and its semaphore is signaled by the scheduler on the switch this requests
+ *  - A thread signals the semaphore right away and only switches if the woken thread has a higher priority
+ * Param "doorbell": doorbell from G8RTOS_AddDoorbell
+ */
+void G8RTOS_RingDoorbell(int32_t doorbell);
+
+
+/*
+ * Adds periodic threads to G8RTOS Scheduler, before or after launch
  * Function will initialize a periodic event struct to represent event.
- * The struct will be added to a linked list of periodic events
+ * The struct will be added to the min heap of periodic events, keyed by release time
+ * Releases stay a whole number of periods after the first one, so they never drift
  * Param Pthread To Add: void-void function for P thread handler
- * Param period: period of P thread to add
+ * Param period: period of P thread to add, in ms
+ * Param overrun: what happens to releases that were missed because the tick ran late
+ * Param context: PERIODIC_DEFERRED runs the handler in the timer thread, PERIODIC_SHORT in the SysTick handler
  * Returns: Error code for adding threads
  */
-int G8RTOS_AddPeriodicEvent(void (*PthreadToAdd)(void), uint32_t period);
+int G8RTOS_AddPeriodicEvent(void (*PthreadToAdd)(void), uint32_t period, periodicOverrun_t overrun, periodicContext_t context);
+
+/*
+ * Returns: Releases of a periodic event that were late by at least a whole period, 0 if there is no such event
+ * Param "handler": handler the event was added with
+ */
+uint32_t G8RTOS_GetMissedReleases(void (*handler)(void));
 
 
 /*
@@ -66,4 +252,62 @@ void G8RTOS_Sleep(uint32_t durationMS);
 
 /*********************************************** Public Functions *********************************************************************/
 
+
+/*********************************************** Kernel Functions *********************************************************************/
+
+/*
+ * Used by the other G8RTOS modules, must be called with interrupts disabled
+ */
+
+/*
+ * Puts a thread at the back of the ready list of its priority level
+ * Param "thread": thread that is no longer blocked or asleep
+ */
+void G8RTOS_AddReady(struct tcb_t *thread);
+
+/*
+ * Takes a thread out of the ready set so the scheduler never looks at it
+ * Param "thread": thread that is about to block or sleep
+ */
+void G8RTOS_RemoveReady(struct tcb_t *thread);
+
+/*
+ * Moves the running thread from the ready set to a semaphore's wait queue
+ *  - Constant time for a FIFO semaphore
+ *  - For a priority semaphore, walks back past the waiters of lower priority, so at most MAX_THREADS steps
+ *  - A timed wait also goes in the sleep list, the tick that wakes it takes it off the queue and sets timedOut
+ * Param "s": semaphore the thread blocks on
+ * Param "timeoutTicks": ticks until the wait times out, or WAIT_FOREVER
+ */
+void G8RTOS_BlockThread(semaphore_t *s, uint32_t timeoutTicks);
+
+/*
+ * Changes the priority a thread runs at, wherever it is waiting
+ *  - A ready thread moves to the back of its new level
+ *  - A thread blocked on a priority semaphore moves to its new place in the wait queue
+ *  - Does not request a context switch, the caller does if the running thread may no longer be the highest
+ * Param "thread": thread to change
+ * Param "priority": new priority, 0 (highest) to IDLE_PRIORITY (lowest)
+ */
+void G8RTOS_SetPriority(struct tcb_t *thread, uint8_t priority);
+
+/*
+ * Unblocks the first thread in a semaphore's wait queue, in constant time
+ *  - Takes it out of the sleep list too if it was a timed wait
+ *  - Requests a context switch if that thread has a higher priority than the running one
+ * Param "s": semaphore that was signaled
+ */
+void G8RTOS_UnblockThread(semaphore_t *s);
+
+/*
+ * Unblocks a given thread from anywhere in the wait queue it is in, in constant time
+ *  - Takes it out of the sleep list too if it was a timed wait
+ *  - Requests a context switch if that thread has a higher priority than the running one
+ *  - Leaves the count of the semaphore to the caller
+ * Param "thread": thread that is blocked
+ */
+void G8RTOS_UnblockWaiter(struct tcb_t *thread);
+
+/*********************************************** Kernel Functions *********************************************************************/
+
 #endif /* G8RTOS_SCHEDULER_H_ */
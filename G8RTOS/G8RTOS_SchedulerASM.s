@@ -6,7 +6,7 @@
 	.def G8RTOS_Start, PendSV_Handler
 
 	; Dependencies
-	.ref CurrentlyRunningThread, G8RTOS_Scheduler
+	.ref CurrentlyRunningThread, G8RTOS_Scheduler, __STACK_END
 
 	.thumb		; Set to thumb mode
 	.align 2	; Align by 2 bytes (thumb mode uses allignment by 2 or 4)
@@ -16,9 +16,13 @@
 ; (label needs to be close enough to asm code to be reached with PC relative addressing)
 RunningPtr: .field CurrentlyRunningThread, 32
 
+; Top of the main stack from the linker, only interrupts use it once threads start
+StackEnd: .field __STACK_END, 32
+
 ; G8RTOS_Start
 ;	Sets the first thread to be the currently running thread
-;	Starts the currently running thread by setting Link Register to tcb's Program Counter
+;	Switches thread mode to the process stack (PSP), interrupts keep the main stack (MSP)
+;	Starts the currently running thread by branching to the tcb's Program Counter
 G8RTOS_Start:
 
 	.asmfunc
@@ -26,31 +30,48 @@ G8RTOS_Start:
 	;Gets the SP from RunningPtr(**CurrentlyRunningThread)
 	ldr r4, RunningPtr
 	ldr r5, [r4,#0]
-	ldr sp, [r5, #0]
+	ldr r0, [r5, #0]
+
+	;Threads run on PSP
+	msr psp, r0
+	mov r0, #2
+	msr control, r0
+	isb
 
-	;Pops registers
+	;Resets MSP to its top, whatever main left on it is no longer needed
+	ldr r0, StackEnd
+	msr msp, r0
+
+	;Pops registers from PSP, the saved EXC_RETURN is not needed to start a thread
 	pop {R4-R11}
+	add sp, sp, #4
 	pop {R0-R3}
 	pop {R12}
+
+	;LR makes the thread end in G8RTOS_ExitThread if it returns
 	pop {LR}
-	pop {LR}
-	pop {XPSR}
+
+	;Pops PC into R0 and skips xPSR
+	pop {R0}
+	add sp, sp, #4
 
 	;Enable interrupts
 	CPSIE I
 
 	;Branches to first thread
-	bx LR
+	bx R0
 
 	.endasmfunc
 
 ; PendSV_Handler
 ; - Performs a context switch in G8RTOS
-; 	- Saves remaining registers into thread stack
-;	- Saves current stack pointer to tcb
-;	- Calls G8RTOS_Scheduler to get new tcb
-;	- Set stack pointer to new stack pointer from new tcb
-;	- Pops registers from thread stack
+; 	- Saves remaining registers and EXC_RETURN into thread stack (PSP)
+;	- Saves S16-S31 only for threads that used the FPU (EXC_RETURN bit 4 clear)
+;	  S0-S15 and FPSCR are lazily stacked by hardware, the first FP instruction here saves them
+;	- Saves thread stack pointer to tcb
+;	- Calls G8RTOS_Scheduler to get new tcb, on the main stack
+;	- Set PSP to new stack pointer from new tcb
+;	- Pops registers from thread stack, and S16-S31 if the new thread used the FPU
 PendSV_Handler:
 	
 	.asmfunc
@@ -58,30 +79,40 @@ PendSV_Handler:
 	;Disables interrupts
 	CPSID I
 
-	;Saves registers
-	push {R4-R11}
+	;Gets the thread stack pointer, below the hardware stacked frame
+	mrs r0, psp
+
+	;Saves FP registers if the thread has an FP frame
+	tst LR, #0x10
+	it eq
+	vstmdbeq r0!, {S16-S31}
 
-	;Stores current stack pointer to TCB
+	;Saves registers and EXC_RETURN
+	stmdb r0!, {R4-R11, LR}
+
+	;Stores thread stack pointer to TCB
 	ldr r4, RunningPtr
 	ldr r5, [r4,#0]
-	str sp, [r5,#0]
-
-	;pushes LR
-	push {LR}
+	str r0, [r5,#0]
 
-	;Updates currently running thread
+	;Updates currently running thread, LR is restored from the new thread's stack
 	BL G8RTOS_Scheduler
 
-	;Pops LR
-	pop {LR}
-
-	;Loads new SP
+	;Loads new thread stack pointer
 	ldr r4, RunningPtr
 	ldr r5, [r4,#0]
-	ldr sp, [r5,#0]
+	ldr r0, [r5,#0]
 
-	;Restores resgisters
-	pop {R4-R11}
+	;Restores resgisters and EXC_RETURN
+	ldmia r0!, {R4-R11, LR}
+
+	;Restores FP registers if the new thread has an FP frame
+	tst LR, #0x10
+	it eq
+	vldmiaeq r0!, {S16-S31}
+
+	;Leaves PSP at the hardware stacked frame
+	msr psp, r0
 
 	;Enables interrupts
 	CPSIE I
@@ -6,29 +6,35 @@
 
 #include <stdint.h>
 #include "msp.h"
+#include "BSP.h"
 #include "G8RTOS_Semaphores.h"
 #include "G8RTOS_CriticalSection.h"
 #include "G8RTOS_Scheduler.h"
 #include "G8RTOS.h"
+#include "G8RTOS_Trace.h"
+#include "G8RTOS_Port.h"
 
 /*********************************************** Dependencies and Externs *************************************************************/
 
-extern tcb_t * CurrentlyRunningThread;
+
 /*********************************************** Public Functions *********************************************************************/
 
 /*
  * Initializes a semaphore to a given value
  * Param "s": Pointer to semaphore
  * Param "value": Value to initialize semaphore to
+ * Param "order": Order waiting threads are woken in
  * THIS IS A CRITICAL SECTION
  */
-void G8RTOS_InitSemaphore(semaphore_t *s, int32_t value)
+void G8RTOS_InitSemaphore(semaphore_t *s, int32_t value, semaphoreOrder_t order)
 {
     //Disables interrupts
     int32_t priMask = StartCriticalSection();
 
-    //Initialize semaphore
-    *s = value;
+    //Initialize semaphore with an empty wait queue
+    s->count = value;
+    s->waiters = 0;
+    s->order = order;
 
     //Enable interrupts
     EndCriticalSection(priMask);
@@ -46,20 +52,23 @@ void G8RTOS_WaitSemaphore(semaphore_t *s)
     //Disable Interrupts
     int32_t priMask = StartCriticalSection();
 
+    G8RTOS_TRACE(TRACE_SEM_WAIT, s);
+
     //Decrement Semaphore since it is available
-    (*s)--;
+    s->count--;
 
     //If the semaphore is less than zero, then thread is blocked since it is unavailable
-    if((*s) < 0)
+    if(s->count < 0)
     {
-        //Block current thread
-        CurrentlyRunningThread->blocked = s;
+        //Moves current thread from the ready set to the semaphore's wait queue
+        G8RTOS_TRACE(TRACE_SEM_BLOCK, s);
+        G8RTOS_BlockThread(s, WAIT_FOREVER);
 
         //Enable Interrupts
         EndCriticalSection(priMask);
 
         //Sets PendSV flag, to yield CPU
-        SCB->ICSR |= (1<<28);
+        G8RTOS_PendSV();
     }
     else
     {
@@ -68,6 +77,61 @@ void G8RTOS_WaitSemaphore(semaphore_t *s)
     }
 }
 
+/*
+ * Waits for a semaphore for a limited time
+ *  - Decrements semaphore when available
+ *  - Otherwise blocks until signaled or until the timeout runs out, which costs no more than a sleep
+ *  - A timeout of 0 never blocks, WAIT_FOREVER is the same as G8RTOS_WaitSemaphore
+ * Param "s": Pointer to semaphore to wait on
+ * Param "timeoutMS": Longest time to wait in ms, rounded up to whole ticks like G8RTOS_Sleep
+ * Returns: SUCCESS if the semaphore was decremented, ERROR if the timeout ran out first
+ * THIS IS A CRITICAL SECTION
+ */
+int32_t G8RTOS_WaitSemaphoreTimeout(semaphore_t *s, uint32_t timeoutMS)
+{
+    //Disable Interrupts
+    int32_t priMask = StartCriticalSection();
+
+    G8RTOS_TRACE(TRACE_SEM_WAIT, s);
+
+    //Available, so no wait at all
+    if(s->count > 0)
+    {
+        s->count--;
+        EndCriticalSection(priMask);
+        return SUCCESS;
+    }
+
+    if(timeoutMS == 0)
+    {
+        EndCriticalSection(priMask);
+        return ERROR;
+    }
+
+    //Blocks in the wait queue and, unless it waits forever, in the sleep list
+    s->count--;
+    G8RTOS_TRACE(TRACE_SEM_BLOCK, s);
+    G8RTOS_BlockThread(s, (timeoutMS == WAIT_FOREVER) ? WAIT_FOREVER : G8RTOS_MsToTicks(timeoutMS));
+
+    //Enable Interrupts
+    EndCriticalSection(priMask);
+
+    //Sets PendSV flag, to yield CPU, the thread runs again once signaled or timed out
+    G8RTOS_PendSV();
+
+    return CurrentlyRunningThread->timedOut ? ERROR : SUCCESS;
+}
+
+/*
+ * Decrements a semaphore only if it is available, never blocks
+ * Param "s": Pointer to semaphore
+ * Returns: SUCCESS if the semaphore was decremented, ERROR if it was not available
+ */
+int32_t G8RTOS_TryWaitSemaphore(semaphore_t *s)
+{
+    return G8RTOS_WaitSemaphoreTimeout(s, 0);
+}
+
 /*
  * Signals the completion of the usage of a semaphore
  *  - Increments the semaphore value by 1
@@ -80,27 +144,20 @@ void G8RTOS_SignalSemaphore(semaphore_t *s)
     //Disables interrupts
     int32_t priMask = StartCriticalSection();
 
+    G8RTOS_TRACE(TRACE_SEM_SIGNAL, s);
+
     //Increment semaphore, to make it available
-    (*s)++;
+    s->count++;
 
     /*
      * IF the semaphore is less than or equal to zero, then
      * that means other threads are waiting on the semaphore.
      * Other threads must be unblocked before proceeding.
      */
-    if((*s) <= 0)
+    if(s->count <= 0)
     {
-        //Creates pointer to next thread
-        tcb_t *pt = CurrentlyRunningThread->next;
-
-        //While pointer is is not blocked, change thread to next
-        while(pt->blocked != s)
-        {
-            pt = pt->next;
-        }
-
-        //Once next block thread is found, it is unblocked
-        pt->blocked = 0;
+        //Unblocks the first thread in the wait queue and makes it ready
+        G8RTOS_UnblockThread(s);
     }
 
     //Enables interrupts
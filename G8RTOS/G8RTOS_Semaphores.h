@@ -5,16 +5,40 @@
 #ifndef G8RTOS_SEMAPHORES_H_
 #define G8RTOS_SEMAPHORES_H_
 
+/*********************************************** Defines ******************************************************************************/
+
+/* Timeout of a wait that never times out */
+#define WAIT_FOREVER 0xFFFFFFFF
+
+/*********************************************** Defines ******************************************************************************/
+
 /*********************************************** Datatype Definitions *****************************************************************/
 
+struct tcb_t;
+
+/*
+ * Order in which the threads blocked on a semaphore are woken
+ */
+typedef enum
+{
+    SEMAPHORE_FIFO, //Thread that has waited longest first
+    SEMAPHORE_PRIORITY //Highest priority thread first, longest waiting among equal priorities
+}semaphoreOrder_t;
+
 /*
  * Semaphore typedef
+ *  - count is the number of units available, or minus the number of threads waiting when negative
+ *  - Waiting threads are linked through their thread control blocks, so waking one takes constant time
+ *  - A zeroed semaphore is a FIFO semaphore with no units
  */
-typedef int32_t semaphore_t;
+typedef struct semaphore_t
+{
+    int32_t count; //Units available, or minus the number of threads waiting
+    struct tcb_t *waiters; //Thread woken next, the queue is circular so its prev is the last one
+    semaphoreOrder_t order; //Order waiting threads are woken in
+}semaphore_t;
 
 /*********************************************** Datatype Definitions *****************************************************************/
-semaphore_t sensorMutex; //Semaphore used for sensor communication
-semaphore_t LEDMutex; //Semaphore used for LED communication
 
 /*********************************************** Public Functions *********************************************************************/
 
@@ -22,20 +46,41 @@ semaphore_t LEDMutex; //Semaphore used for LED communication
  * Initializes a semaphore to a given value
  * Param "s": Pointer to semaphore
  * Param "value": Value to initialize semaphore to
+ * Param "order": Order waiting threads are woken in
  */
-void G8RTOS_InitSemaphore(semaphore_t *s, int32_t value);
+void G8RTOS_InitSemaphore(semaphore_t *s, int32_t value, semaphoreOrder_t order);
 
 /*
  * Waits for a semaphore to be available (value greater than 0)
  * 	- Decrements semaphore when available
- * 	- Spinlocks to wait for semaphore
+ * 	- Blocks on the semaphore's wait queue until signaled
  * Param "s": Pointer to semaphore to wait on
  */
 void G8RTOS_WaitSemaphore(semaphore_t *s);
 
+/*
+ * Waits for a semaphore for a limited time
+ * 	- Decrements semaphore when available
+ * 	- Otherwise blocks until signaled or until the timeout runs out, which costs no more than a sleep
+ * 	- A timeout of 0 never blocks, WAIT_FOREVER is the same as G8RTOS_WaitSemaphore
+ * 	- Must not be called inside a critical section, the switch has to happen before the result is known
+ * Param "s": Pointer to semaphore to wait on
+ * Param "timeoutMS": Longest time to wait in ms, rounded up to whole ticks like G8RTOS_Sleep
+ * Returns: SUCCESS if the semaphore was decremented, ERROR if the timeout ran out first
+ */
+int32_t G8RTOS_WaitSemaphoreTimeout(semaphore_t *s, uint32_t timeoutMS);
+
+/*
+ * Decrements a semaphore only if it is available, never blocks
+ * Param "s": Pointer to semaphore
+ * Returns: SUCCESS if the semaphore was decremented, ERROR if it was not available
+ */
+int32_t G8RTOS_TryWaitSemaphore(semaphore_t *s);
+
 /*
  * Signals the completion of the usage of a semaphore
  * 	- Increments the semaphore value by 1
+ * 	- Wakes the first thread in the semaphore's wait queue, if any
  * Param "s": Pointer to semaphore to be signalled
  */
 void G8RTOS_SignalSemaphore(semaphore_t *s);
@@ -17,20 +17,36 @@
  *  Thread Control Block:
  *      - Every thread has a Thread Control Block
  *      - The Thread Control Block holds information about the Thread Such as the Stack Pointer, Priority Level, and Blocked Status
- *      - For Lab 2 the TCB will only hold the Stack Pointer, next TCB and the previous TCB (for Round Robin Scheduling)
+ *      - prev and next link the TCB into the ready list of its priority level while the thread is ready,
+ *        or into the wait queue of the semaphore it is blocked on, and are not valid otherwise
  */
 
 typedef struct tcb_t
 {
-    /*
-    bool alive;
-    uint8_t priority;*/
     int32_t* sp; //Holds pointer to stack pointer for respective tcb_t
-    struct tcb_t *prev; //Holds pointer to previous tcb_t
-    struct tcb_t *next; //HOlds pointer to next tcb_t
+    struct tcb_t *prev; //Holds pointer to previous tcb_t in the same ready list or wait queue
+    struct tcb_t *next; //HOlds pointer to next tcb_t in the same ready list or wait queue
     bool asleep; //Tells if thread is asleep
     uint32_t sleepCount; //Holds time wanted to sleep
+    struct tcb_t *sleepPrev; //Holds pointer to thread that wakes up before this one
+    struct tcb_t *sleepNext; //Holds pointer to thread that wakes up after this one
     semaphore_t *blocked; // 0(not blocked) or semaphore thread  that is currently being waited for.
+    bool timedOut; //Set when the thread's last timed wait ran out of time before it was signaled
+    uint32_t eventMask; //Flags the thread is blocked on in an event flag group, then the flags that woke it
+    uint8_t eventOptions; //How the flags in eventMask are waited for, EVENT_FLAGS_ALL and EVENT_FLAGS_CLEAR
+    uint32_t eventSet; //Sets of its event flag group when it blocked, a set checks only the waiters that blocked before it
+    uint32_t waitCount; //Elements the thread is blocked on a FIFO for, data for a reader or room for a writer
+    uint8_t priority; //Priority level, 0 is the highest
+    uint8_t basePriority; //Priority given when the thread was added, priority is only above it while holding mutexes
+    struct mutex_t *heldMutexes; //Mutexes the thread holds, linked through their nextHeld
+    struct mutex_t *waitingMutex; //Mutex the thread is blocked on, so its priority can be passed to the owner
+    bool alive; //False while the thread control block is on the free list
+    threadId_t id; //Id given when the thread was added
+    semaphore_t exited; //Threads waiting for this one to end block on it
+    int32_t *stackBase; //Holds pointer to the bottom of the thread's stack
+    uint32_t stackSize; //Size of the thread's stack in bytes
+    uint64_t cpuCycles; //Cycles the thread has run, periodic handlers and interrupts not included
+    uint64_t snapshotCycles; //cpuCycles at the last CPU load snapshot
 
 }tcb_t;
 
@@ -38,18 +54,21 @@ typedef struct tcb_t
 /*
  *  Periodic Thread Control Block:
  *      - Holds a function pointer that points to the periodic thread to be executed
- *      - Has a period in us
- *      - Holds Current time
- *      - Contains pointer to the next periodic event - linked list
+ *      - Has a period in ticks
+ *      - Holds the absolute time of its next release, kept on the grid of its first release
+ *      - Lives in the min heap of periodic events, and in the timer queue while deferred releases wait
  */
 typedef struct ptcb_t
 {
     void (*Handler)(void); //Function pointer
-    uint32_t period; //Holds period
+    uint32_t period; //Holds period in ticks
     uint32_t executeTime; //Holds time that will be executed
     uint32_t currentTime; //Default starting value
-    struct ptcb_t *prev; //Holds previous periodic thread
-    struct ptcb_t *next; //Holds next periodic thread
+    periodicOverrun_t overrun; //What happens to releases missed because the tick ran late
+    uint32_t missedReleases; //Counts releases that were late by at least a whole period
+    periodicContext_t context; //Runs in the SysTick handler or is deferred to the timer thread
+    uint32_t pendingReleases; //Deferred releases the timer thread has not run yet
+    struct ptcb_t *nextPending; //Holds next periodic thread in the timer queue
 
 }ptcb_t;
 
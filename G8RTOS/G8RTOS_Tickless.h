@@ -0,0 +1,62 @@
+/*
+ * G8RTOS_Tickless.h
+ *
+ * Arithmetic used by the idle thread to stretch one timer period over several ticks.
+ * The timer is a down-counter (SysTick on the board, a simulated counter on the host)
+ * that fires when it reaches zero, so all values here are "cycles left" counts.
+ */
+
+#ifndef G8RTOS_TICKLESS_H_
+#define G8RTOS_TICKLESS_H_
+
+#include <stdint.h>
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Reload value that makes the counter fire on the tick boundary "idleTicks" ticks from now
+ * Param "idleTicks": number of tick boundaries to skip, at least 1
+ * Param "cyclesPerTick": counter cycles in one tick
+ * Param "count": cycles left until the next tick boundary
+ * Returns: reload value for the counter
+ */
+static inline uint32_t Tickless_Reload(uint32_t idleTicks, uint32_t cyclesPerTick, uint32_t count)
+{
+    return count + (idleTicks - 1) * cyclesPerTick;
+}
+
+/*
+ * Largest number of ticks that fits in a counter of a given size
+ * Param "cyclesPerTick": counter cycles in one tick
+ * Param "maxReload": largest reload value the counter accepts
+ */
+static inline uint32_t Tickless_MaxIdleTicks(uint32_t cyclesPerTick, uint32_t maxReload)
+{
+    return maxReload / cyclesPerTick;
+}
+
+/*
+ * Tick boundaries that have been crossed when the core woke up before the counter fired
+ * Param "idleTicks": value passed to Tickless_Reload
+ * Param "cyclesPerTick": counter cycles in one tick
+ * Param "count": cycles the counter had left when it was stopped, greater than zero
+ * Returns: ticks to add to SystemTime
+ */
+static inline uint32_t Tickless_ElapsedTicks(uint32_t idleTicks, uint32_t cyclesPerTick, uint32_t count)
+{
+    return idleTicks - (count + cyclesPerTick - 1) / cyclesPerTick;
+}
+
+/*
+ * Cycles left until the next tick boundary when the core woke up before the counter fired
+ * Param "cyclesPerTick": counter cycles in one tick
+ * Param "count": cycles the counter had left when it was stopped, greater than zero
+ */
+static inline uint32_t Tickless_CyclesToNextTick(uint32_t cyclesPerTick, uint32_t count)
+{
+    return ((count - 1) % cyclesPerTick) + 1;
+}
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif /* G8RTOS_TICKLESS_H_ */
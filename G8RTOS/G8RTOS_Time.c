@@ -0,0 +1,118 @@
+/*
+ * G8RTOS_Time.c
+ */
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+#include <stdint.h>
+#include "msp.h"
+#include "G8RTOS_Time.h"
+#include "G8RTOS_Scheduler.h"
+#include "G8RTOS_CriticalSection.h"
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+
+/*********************************************** Private Variables ********************************************************************/
+
+/* Upper 32 bits of the tick count, SystemTime holds the lower 32 bits */
+static uint32_t SystemTimeHigh;
+
+/* Core clock cycles in one tick */
+static uint32_t CyclesPerTick;
+
+/* Core clock cycles in one microsecond */
+static uint32_t CyclesPerUs;
+
+/*********************************************** Private Variables ********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Starts the time base, called once by G8RTOS_Launch before SysTick is started
+ * Param "clkFreq": core clock frequency in Hz
+ * Returns: core clock cycles in one tick
+ */
+uint32_t G8RTOS_InitTime(uint32_t clkFreq)
+{
+    SystemTimeHigh = 0;
+    CyclesPerTick = clkFreq / G8RTOS_TICK_HZ;
+    CyclesPerUs = clkFreq / 1000000;
+
+    //Starts the DWT cycle counter
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    return CyclesPerTick;
+}
+
+/*
+ * Adds ticks to SystemTime and carries into the upper 32 bits when it wraps
+ * Param "ticks": ticks that went by
+ * Must be called with interrupts disabled
+ */
+void G8RTOS_AdvanceTime(uint32_t ticks)
+{
+    uint32_t oldTime = SystemTime;
+    SystemTime += ticks;
+
+    if(SystemTime < oldTime)
+    {
+        SystemTimeHigh++;
+    }
+}
+
+/*
+ * Core clock cycles since G8RTOS_Launch
+ *  - Whole ticks times the tick length, plus how far SysTick has counted into the current tick
+ * THIS IS A CRITICAL SECTION
+ */
+uint64_t G8RTOS_GetTimeCycles(void)
+{
+    //Disables interrupts so the tick count and SysTick are read together
+    int32_t priMask = StartCriticalSection();
+
+    uint32_t count = SysTick->VAL;
+    uint64_t ticks = ((uint64_t)SystemTimeHigh << 32) | SystemTime;
+
+    //SysTick wrapped but its handler has not run yet, so the tick is counted here
+    if(SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
+    {
+        count = SysTick->VAL;
+        ticks++;
+    }
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+
+    //SysTick counts down to the next tick boundary
+    return ticks * CyclesPerTick + (CyclesPerTick - 1 - count);
+}
+
+/*
+ * Nanoseconds since G8RTOS_Launch, in steps of one core clock cycle
+ */
+uint64_t G8RTOS_GetTimeNs(void)
+{
+    return G8RTOS_GetTimeCycles() * 1000 / CyclesPerUs;
+}
+
+/*
+ * Microseconds since G8RTOS_Launch
+ */
+uint64_t G8RTOS_GetTimeUs(void)
+{
+    return G8RTOS_GetTimeCycles() / CyclesPerUs;
+}
+
+/*
+ * Milliseconds since G8RTOS_Launch
+ */
+uint64_t G8RTOS_GetTimeMs(void)
+{
+    return G8RTOS_GetTimeCycles() / (CyclesPerUs * 1000);
+}
+
+/*********************************************** Public Functions *********************************************************************/
@@ -0,0 +1,88 @@
+/*
+ * G8RTOS_Time.h
+ *
+ * 64 bit monotonic time base
+ *  - Whole ticks come from SystemTime, extended to 64 bits
+ *  - The position inside the current tick comes from SysTick, so time keeps moving while the idle thread sleeps
+ */
+
+#ifndef G8RTOS_TIME_H_
+#define G8RTOS_TIME_H_
+
+#include <stdint.h>
+#include "msp.h"
+
+/*********************************************** Configuration ************************************************************************/
+
+/* SysTick interrupts per second, SystemTime, sleeps and periodic releases all count in these ticks */
+#ifndef G8RTOS_TICK_HZ
+#define G8RTOS_TICK_HZ 1000
+#endif
+
+/*********************************************** Configuration ************************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Starts the time base, called once by G8RTOS_Launch before SysTick is started
+ *  - The clock frequency must be a whole number of MHz, true for every MSP432 clock setting
+ * Param "clkFreq": core clock frequency in Hz
+ * Returns: core clock cycles in one tick
+ */
+uint32_t G8RTOS_InitTime(uint32_t clkFreq);
+
+/*
+ * Adds ticks to SystemTime and carries into the upper 32 bits when it wraps
+ * Param "ticks": ticks that went by
+ * Must be called with interrupts disabled
+ */
+void G8RTOS_AdvanceTime(uint32_t ticks);
+
+/*
+ * Core clock cycles since G8RTOS_Launch
+ */
+uint64_t G8RTOS_GetTimeCycles(void);
+
+/*
+ * Nanoseconds since G8RTOS_Launch, in steps of one core clock cycle
+ */
+uint64_t G8RTOS_GetTimeNs(void);
+
+/*
+ * Microseconds since G8RTOS_Launch
+ */
+uint64_t G8RTOS_GetTimeUs(void);
+
+/*
+ * Milliseconds since G8RTOS_Launch
+ */
+uint64_t G8RTOS_GetTimeMs(void);
+
+/*
+ * Raw DWT cycle counter, a few cycles to read
+ *  - Wraps every 2^32 cycles and stops while the core sleeps in WFI
+ *  - Meant for short intervals of running code, such as one I2C transfer
+ */
+static inline uint32_t G8RTOS_GetCycleCount(void)
+{
+    return DWT->CYCCNT;
+}
+
+/*
+ * Converts milliseconds to ticks, rounding up so a wait is never shorter than asked
+ * Param "ms": milliseconds
+ * Returns: ticks
+ */
+static inline uint32_t G8RTOS_MsToTicks(uint32_t ms)
+{
+#if (G8RTOS_TICK_HZ == 1000)
+    return ms;
+#else
+    return (uint32_t)(((uint64_t)ms * G8RTOS_TICK_HZ + 999) / 1000);
+#endif
+}
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif /* G8RTOS_TIME_H_ */
@@ -0,0 +1,295 @@
+/*
+ * G8RTOS_Topic.c
+ */
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include "msp.h"
+#include "BSP.h"
+#include "G8RTOS_Topic.h"
+#include "G8RTOS_Semaphores.h"
+#include "G8RTOS_CriticalSection.h"
+#include "G8RTOS_Scheduler.h"
+#include "G8RTOS.h"
+#include "G8RTOS_Trace.h"
+#include "G8RTOS_Port.h"
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+/*
+ * Index counts up forever and is masked into the ring, so a subscriber is writeIndex - readIndex samples behind
+ *  - A subscriber blocks on the wait queue picked by the index it waits past, so one that is woken, reads
+ *    and blocks again while a publish is still waking the rest goes on the other queue
+ */
+typedef struct topic_t
+{
+    const char *name; //Name it is found by, 0 while the topic is not in use
+    uint8_t *buffer; //Caller's storage
+    uint32_t mask; //Depth - 1, the depth is a power of two
+    uint32_t elementSize; //Bytes in one sample
+    volatile uint32_t writeIndex; //Samples published so far
+    semaphore_t waiters[2]; //Subscribers blocked until the next sample, its count is minus the number of them
+}topic_t;
+
+/* Array of topics */
+static topic_t Topics[MAX_NUMBER_OF_TOPICS];
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+
+/*********************************************** Private Functions ********************************************************************/
+
+/*
+ * Returns: place in the ring of a sample
+ * Param "topic": topic the sample is in
+ * Param "index": read or write index of the sample
+ */
+static inline uint8_t *Sample(topic_t *topic, uint32_t index)
+{
+    return topic->buffer + (index & topic->mask) * topic->elementSize;
+}
+
+/*********************************************** Private Functions ********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Creates a topic in storage given by the caller
+ * Param "name": name subscribers find the topic by, kept by the topic
+ * Param "buffer": storage for "depth" samples, used by the topic for good
+ * Param "depth": samples a subscriber may fall behind before it misses some, a power of two
+ * Param "elementSize": bytes in one sample, sizeof its type
+ * Returns: handle of the topic, or 0 if an argument is wrong, the name is taken or MAX_NUMBER_OF_TOPICS are in use
+ * THIS IS A CRITICAL SECTION
+ */
+topicHandle_t G8RTOS_CreateTopic(const char *name, void *buffer, uint32_t depth, uint32_t elementSize)
+{
+    //Depth has to be a power of two for the indices to be masked
+    if(name == 0 || buffer == 0 || depth == 0 || (depth & (depth - 1)) != 0 || elementSize == 0)
+    {
+        return 0;
+    }
+
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    //Finds a topic not in use, names have to be unique
+    topic_t *topic = 0;
+    for(uint32_t i = 0; i < MAX_NUMBER_OF_TOPICS; i++)
+    {
+        if(Topics[i].name == 0)
+        {
+            if(topic == 0)
+            {
+                topic = &Topics[i];
+            }
+        }
+        else if(strcmp(Topics[i].name, name) == 0)
+        {
+            EndCriticalSection(priMask);
+            return 0;
+        }
+    }
+
+    if(topic == 0)
+    {
+        EndCriticalSection(priMask);
+        return 0;
+    }
+
+    topic->name = name;
+    topic->buffer = buffer;
+    topic->mask = depth - 1;
+    topic->elementSize = elementSize;
+    topic->writeIndex = 0;
+    G8RTOS_InitSemaphore(&topic->waiters[0], 0, SEMAPHORE_FIFO);
+    G8RTOS_InitSemaphore(&topic->waiters[1], 0, SEMAPHORE_FIFO);
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+    return topic;
+}
+
+/*
+ * Returns: handle of the topic with a name, or 0 if there is none
+ * Param "name": name the topic was created with
+ */
+topicHandle_t G8RTOS_FindTopic(const char *name)
+{
+    for(uint32_t i = 0; i < MAX_NUMBER_OF_TOPICS; i++)
+    {
+        if(Topics[i].name != 0 && strcmp(Topics[i].name, name) == 0)
+        {
+            return &Topics[i];
+        }
+    }
+    return 0;
+}
+
+/*
+ * Subscribes to a topic, from the next sample published on
+ * Param "s": Pointer to subscriber, only read by one thread
+ * Param "topic": topic to read
+ */
+void G8RTOS_Subscribe(subscriber_t *s, topicHandle_t topic)
+{
+    s->topic = topic;
+    s->readIndex = topic->writeIndex;
+    s->missed = 0;
+}
+
+/*
+ * Publishes a sample to every subscriber of a topic, may be called from an interrupt
+ *  - Overwrites the oldest sample in the ring, wakes the subscribers waiting for a sample
+ *  - Wakes them one at a time, interrupts are never held off for more than one of them
+ * Param "topic": topic to publish on
+ * Param "data": sample being published
+ * THIS IS A CRITICAL SECTION
+ */
+void G8RTOS_Publish(topicHandle_t topic, const void *data)
+{
+    //Disables interrupts
+    int32_t priMask = StartCriticalSection();
+
+    //Subscribers waiting for this sample, later ones block on the other queue
+    semaphore_t *queue = &topic->waiters[topic->writeIndex & 1];
+    int32_t waiting = -queue->count;
+
+    //Sample is in the ring before a subscriber can see the new index
+    memcpy(Sample(topic, topic->writeIndex), data, topic->elementSize);
+    __DMB();
+    topic->writeIndex++;
+    G8RTOS_TRACE(TRACE_TOPIC_PUBLISH, topic);
+
+    //Enables interrupts
+    EndCriticalSection(priMask);
+
+    //Wakes the ones that were waiting, the ones reading along never blocked
+    // - Queue is in arrival order, a subscriber that blocks on it again two publishes later is behind all of them
+    // - Never more than were waiting, one woken that is waiting again costs a spurious wakeup at most
+    while(waiting-- > 0)
+    {
+        priMask = StartCriticalSection();
+
+        //Left by timing out or being killed meanwhile
+        if(queue->count >= 0)
+        {
+            EndCriticalSection(priMask);
+            break;
+        }
+        queue->count++;
+        G8RTOS_UnblockThread(queue);
+
+        EndCriticalSection(priMask);
+    }
+}
+
+/*
+ * Reads the oldest sample of a topic a subscriber has not read
+ *  - Copies without disabling interrupts, a sample overwritten while it was copied is thrown away and counted as missed
+ *  - A subscriber that fell too far behind skips to the oldest sample still in the ring
+ *  - A timeout of 0 never blocks
+ * Param "s": Pointer to subscriber
+ * Param "data": where the sample read is stored
+ * Param "timeoutMS": longest time to wait for a sample in ms, or WAIT_FOREVER
+ * Returns: SUCCESS, or ERROR if no sample came in time
+ * THIS IS A CRITICAL SECTION
+ */
+int G8RTOS_ReadTopic(subscriber_t *s, void *data, uint32_t timeoutMS)
+{
+    topic_t *topic = s->topic;
+
+    uint32_t deadline = 0;
+    if(timeoutMS != WAIT_FOREVER)
+    {
+        deadline = SystemTime + G8RTOS_MsToTicks(timeoutMS);
+    }
+
+    while(1)
+    {
+        uint32_t read = s->readIndex;
+        uint32_t behind = topic->writeIndex - read;
+
+        //Lagging, the samples it did not get to are gone
+        if(behind > topic->mask + 1)
+        {
+            G8RTOS_TRACE(TRACE_TOPIC_LAG, topic);
+            s->missed += behind - (topic->mask + 1);
+            s->readIndex = read + behind - (topic->mask + 1);
+            continue;
+        }
+
+        if(behind != 0)
+        {
+            //Sample is read only after the index that published it
+            __DMB();
+            memcpy(data, Sample(topic, read), topic->elementSize);
+            __DMB();
+
+            //Publisher may have reused the place while it was copied, which shows as lagging on the next pass
+            if(topic->writeIndex - read > topic->mask + 1)
+            {
+                continue;
+            }
+
+            s->readIndex = read + 1;
+            return SUCCESS;
+        }
+
+        //Disables interrupts
+        int32_t priMask = StartCriticalSection();
+
+        //Published since it was checked
+        if(topic->writeIndex != read)
+        {
+            EndCriticalSection(priMask);
+            continue;
+        }
+
+        //Time is left only while the deadline is still ahead
+        uint32_t ticks = WAIT_FOREVER;
+        if(timeoutMS != WAIT_FOREVER)
+        {
+            ticks = deadline - SystemTime;
+            if(timeoutMS == 0 || (int32_t)ticks <= 0)
+            {
+                EndCriticalSection(priMask);
+                return ERROR;
+            }
+        }
+
+        //Blocks until the next publish
+        semaphore_t *queue = &topic->waiters[read & 1];
+        G8RTOS_TRACE(TRACE_SEM_BLOCK, queue);
+        queue->count--;
+        G8RTOS_BlockThread(queue, ticks);
+
+        //Enables interrupts
+        EndCriticalSection(priMask);
+
+        //Sets PendSV flag, to yield CPU, the thread runs again once woken or timed out
+        G8RTOS_PendSV();
+
+        if(CurrentlyRunningThread->timedOut)
+        {
+            return ERROR;
+        }
+    }
+}
+
+/*
+ * Returns: Samples a subscriber missed because it lagged behind the publisher, 0 if it has kept up
+ * Param "s": Pointer to subscriber
+ */
+uint32_t G8RTOS_GetMissedSamples(subscriber_t *s)
+{
+    return s->missed;
+}
+
+/*********************************************** Public Functions *********************************************************************/
@@ -0,0 +1,97 @@
+/*
+ * G8RTOS_Topic.h
+ *
+ * Publish/subscribe topics, one stream of samples any number of threads can read
+ *  - A topic is a ring of the newest samples, found by its name
+ *  - Every subscriber has its own read cursor into the ring, the topic does not know its subscribers
+ *  - Publishing copies one sample and never waits, so it may be done from an interrupt,
+ *    subscribers that are blocked are woken one at a time with interrupts enabled in between
+ *  - A subscriber that falls more than the depth behind misses the overwritten samples and counts them,
+ *    the publisher is never held up by it
+ */
+
+#ifndef G8RTOS_TOPIC_H_
+#define G8RTOS_TOPIC_H_
+
+#include <stdint.h>
+
+/* Topics that can exist, their rings are given by the caller */
+#ifndef MAX_NUMBER_OF_TOPICS
+#define MAX_NUMBER_OF_TOPICS 4
+#endif
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+/*
+ * Topic handle, what the topic functions take
+ */
+typedef struct topic_t *topicHandle_t;
+
+/*
+ * Subscriber typedef, one per reading thread
+ */
+typedef struct subscriber_t
+{
+    struct topic_t *topic; //Topic read
+    uint32_t readIndex; //Samples of the topic read or missed so far
+    uint32_t missed; //Samples overwritten before they were read
+}subscriber_t;
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Creates a topic in storage given by the caller
+ * Param "name": name subscribers find the topic by, kept by the topic
+ * Param "buffer": storage for "depth" samples, used by the topic for good
+ * Param "depth": samples a subscriber may fall behind before it misses some, a power of two
+ * Param "elementSize": bytes in one sample, sizeof its type
+ * Returns: handle of the topic, or 0 if an argument is wrong, the name is taken or MAX_NUMBER_OF_TOPICS are in use
+ */
+topicHandle_t G8RTOS_CreateTopic(const char *name, void *buffer, uint32_t depth, uint32_t elementSize);
+
+/*
+ * Returns: handle of the topic with a name, or 0 if there is none
+ * Param "name": name the topic was created with
+ */
+topicHandle_t G8RTOS_FindTopic(const char *name);
+
+/*
+ * Subscribes to a topic, from the next sample published on
+ * Param "s": Pointer to subscriber, only read by one thread
+ * Param "topic": topic to read
+ */
+void G8RTOS_Subscribe(subscriber_t *s, topicHandle_t topic);
+
+/*
+ * Publishes a sample to every subscriber of a topic, may be called from an interrupt
+ *  - Overwrites the oldest sample in the ring, wakes the subscribers waiting for a sample
+ *  - Wakes them one at a time, interrupts are never held off for more than one of them
+ * Param "topic": topic to publish on
+ * Param "data": sample being published
+ */
+void G8RTOS_Publish(topicHandle_t topic, const void *data);
+
+/*
+ * Reads the oldest sample of a topic a subscriber has not read
+ *  - A subscriber that fell too far behind skips to the oldest sample still in the ring
+ *  - A timeout of 0 never blocks
+ *  - Not to be used from an interrupt
+ * Param "s": Pointer to subscriber
+ * Param "data": where the sample read is stored
+ * Param "timeoutMS": longest time to wait for a sample in ms, or WAIT_FOREVER
+ * Returns: SUCCESS, or ERROR if no sample came in time
+ */
+int G8RTOS_ReadTopic(subscriber_t *s, void *data, uint32_t timeoutMS);
+
+/*
+ * Returns: Samples a subscriber missed because it lagged behind the publisher, 0 if it has kept up
+ * Param "s": Pointer to subscriber
+ */
+uint32_t G8RTOS_GetMissedSamples(subscriber_t *s);
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif /* G8RTOS_TOPIC_H_ */
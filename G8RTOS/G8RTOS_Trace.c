@@ -0,0 +1,153 @@
+/*
+ * G8RTOS_Trace.c
+ */
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+#include <stdint.h>
+#include <driverlib.h>
+#include "msp.h"
+#include "BSP.h"
+#include "G8RTOS_Trace.h"
+#include "G8RTOS_Time.h"
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+
+/*********************************************** Public Variables *********************************************************************/
+
+/* Held by whoever writes to the back channel UART (EUSCI_A0), initialized by G8RTOS_Init */
+mutex_t G8RTOS_BackChannelMutex;
+
+/*********************************************** Public Variables *********************************************************************/
+
+#if (KERNEL_TRACE == 1)
+
+/*********************************************** Defines ******************************************************************************/
+
+/* Most records sent in one batch */
+#define TRACE_BATCH_EVENTS 32
+
+/* Time the trace thread sleeps when the ring is empty, in ms */
+#define TRACE_DRAIN_MS 10
+
+/*********************************************** Defines ******************************************************************************/
+
+
+/*********************************************** Public Variables *********************************************************************/
+
+/* Trace ring, written by G8RTOS_TraceRecord */
+traceRecord_t G8RTOS_TraceRing[TRACE_BUFFER_EVENTS];
+
+/* Records claimed so far, the next record goes at this index modulo the ring size */
+volatile uint32_t G8RTOS_TraceHead;
+
+/*********************************************** Public Variables *********************************************************************/
+
+
+/*********************************************** Private Variables ********************************************************************/
+
+/* Index of the next record to send */
+static uint32_t TraceTail;
+
+/*********************************************** Private Variables ********************************************************************/
+
+
+/*********************************************** Private Functions ********************************************************************/
+
+/*
+ * Sends raw bytes over the back channel UART
+ * Param "data": bytes to send
+ * Param "size": number of bytes
+ */
+static void TraceSend(const void *data, uint32_t size)
+{
+    const uint8_t *bytes = data;
+    while(size--)
+    {
+        MAP_UART_transmitData(EUSCI_A0_BASE, *bytes++);
+    }
+}
+
+/*********************************************** Private Functions ********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Trace thread, added by G8RTOS_Launch at TRACE_PRIORITY
+ *  - Sends the ring over the back channel UART, sleeps when it is empty
+ *  - Runs below every thread that records events, so no record it copies is half written
+ *  - Holds the back channel UART only while a batch is sent
+ */
+void G8RTOS_TraceThread(void)
+{
+    traceRecord_t records[TRACE_BATCH_EVENTS];
+    traceBatch_t batch;
+
+    batch.magic = TRACE_BATCH_MAGIC;
+    batch.clkFreq = ClockSys_GetSysFreq();
+    batch.cyclesPerTick = batch.clkFreq / G8RTOS_TICK_HZ;
+
+    while(1)
+    {
+        uint32_t head = G8RTOS_TraceHead;
+        uint32_t lost = 0;
+
+        //Records the writers lapped are gone
+        if(head - TraceTail > TRACE_BUFFER_EVENTS)
+        {
+            lost = head - TraceTail - TRACE_BUFFER_EVENTS;
+            TraceTail = head - TRACE_BUFFER_EVENTS;
+        }
+
+        uint32_t count = head - TraceTail;
+        if(count == 0)
+        {
+            G8RTOS_Sleep(TRACE_DRAIN_MS);
+            continue;
+        }
+        if(count > TRACE_BATCH_EVENTS)
+        {
+            count = TRACE_BATCH_EVENTS;
+        }
+
+        for(uint32_t i = 0; i < count; i++)
+        {
+            records[i] = G8RTOS_TraceRing[(TraceTail + i) & (TRACE_BUFFER_EVENTS - 1)];
+        }
+
+        //Records overwritten while they were copied are dropped from the front of the batch
+        uint32_t first = 0;
+        head = G8RTOS_TraceHead;
+        if(head - TraceTail > TRACE_BUFFER_EVENTS)
+        {
+            first = head - TraceTail - TRACE_BUFFER_EVENTS;
+            if(first > count)
+            {
+                first = count;
+            }
+            lost += first;
+        }
+        TraceTail += count;
+
+        batch.count = count - first;
+        batch.lost = (lost > 0xFFFF) ? 0xFFFF : lost;
+
+        //Whole batch goes out in one piece, a thread printing meanwhile waits and lends its priority
+        G8RTOS_LockMutex(&G8RTOS_BackChannelMutex);
+        TraceSend(&batch, sizeof(batch));
+        TraceSend(&records[first], batch.count * sizeof(traceRecord_t));
+        G8RTOS_UnlockMutex(&G8RTOS_BackChannelMutex);
+
+        //Ring was drained, waits for more instead of sending the records of its own lock and unlock right away
+        if(count < TRACE_BATCH_EVENTS)
+        {
+            G8RTOS_Sleep(TRACE_DRAIN_MS);
+        }
+    }
+}
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif
@@ -0,0 +1,155 @@
+/*
+ * G8RTOS_Trace.h
+ *
+ * Kernel event tracer
+ *  - Enabled with KERNEL_TRACE, every G8RTOS_TRACE call compiles to nothing otherwise
+ *  - Events are fixed size records in a RAM ring, claimed without disabling interrupts
+ *  - The kernel trace thread drains the ring over the back channel UART in batches,
+ *    holding G8RTOS_BackChannelMutex so text the application sends on it never lands inside a batch
+ *  - Tools/g8trace2chrome.py turns the stream into Chrome trace JSON for Perfetto
+ */
+
+#ifndef G8RTOS_TRACE_H_
+#define G8RTOS_TRACE_H_
+
+#include <stdint.h>
+#include "msp.h"
+#include "G8RTOS_Scheduler.h"
+#include "G8RTOS_Mutex.h"
+
+/*********************************************** Defines ******************************************************************************/
+
+/* Records in the trace ring, must be a power of two */
+#define TRACE_BUFFER_EVENTS 256
+
+/* First word of every batch sent by the trace thread, "G8TR" in little endian */
+#define TRACE_BATCH_MAGIC 0x52543847
+
+/*********************************************** Defines ******************************************************************************/
+
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+/*
+ * Kind of a trace record, and what its argument holds
+ */
+typedef enum
+{
+    TRACE_SWITCH = 1, //Id of the thread switched to
+    TRACE_SEM_WAIT, //Semaphore address
+    TRACE_SEM_BLOCK, //Semaphore address
+    TRACE_SEM_SIGNAL, //Semaphore address
+    TRACE_SEM_UNBLOCK, //Id of the thread made ready
+    TRACE_FIFO_READ, //FIFO address
+    TRACE_FIFO_WRITE, //FIFO address
+    TRACE_FIFO_DROP, //FIFO address
+    TRACE_PERIODIC_RELEASE, //Handler address
+    TRACE_ISR_ENTER, //Exception number, as in VECTACTIVE
+    TRACE_ISR_EXIT, //Exception number, as in VECTACTIVE
+    TRACE_MUTEX_LOCK, //Mutex address
+    TRACE_MUTEX_BLOCK, //Mutex address
+    TRACE_MUTEX_UNLOCK, //Mutex address
+    TRACE_FLAGS_SET, //Event flag group address
+    TRACE_FLAGS_BLOCK, //Event flag group address
+    TRACE_TOPIC_PUBLISH, //Topic address
+    TRACE_TOPIC_LAG //Topic address, a subscriber skipped samples it missed
+}traceEvent_t;
+
+/*
+ * One trace record, 12 bytes
+ *  - Time is the tick count and the SysTick count in that tick, the host turns them into cycles
+ */
+typedef struct
+{
+    uint32_t ticks; //SystemTime when the event happened
+    uint32_t countAndType; //SysTick count in the low 24 bits, traceEvent_t in the high 8 bits
+    uint32_t arg; //Depends on the event type
+}traceRecord_t;
+
+/*
+ * Header in front of every batch sent by the trace thread, followed by "count" records
+ */
+typedef struct
+{
+    uint32_t magic; //TRACE_BATCH_MAGIC
+    uint32_t clkFreq; //Core clock in Hz
+    uint32_t cyclesPerTick; //SysTick cycles in one tick
+    uint16_t count; //Records that follow
+    uint16_t lost; //Records overwritten before they were sent, since the last batch
+}traceBatch_t;
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+
+/*********************************************** Public Variables *********************************************************************/
+
+/* Held by whoever writes to the back channel UART (EUSCI_A0), initialized by G8RTOS_Init */
+extern mutex_t G8RTOS_BackChannelMutex;
+
+/*********************************************** Public Variables *********************************************************************/
+
+
+#if (KERNEL_TRACE == 1)
+
+/*********************************************** Public Variables *********************************************************************/
+
+/* Trace ring, written by G8RTOS_TraceRecord */
+extern traceRecord_t G8RTOS_TraceRing[TRACE_BUFFER_EVENTS];
+
+/* Records claimed so far, the next record goes at this index modulo the ring size */
+extern volatile uint32_t G8RTOS_TraceHead;
+
+/*********************************************** Public Variables *********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Records one event in the trace ring, the oldest record is overwritten when the ring is full
+ *  - Safe from threads and interrupts, a slot is claimed with LDREX/STREX
+ * Param "type": traceEvent_t of the event
+ * Param "arg": argument of the event
+ */
+static inline void G8RTOS_TraceRecord(uint32_t type, uint32_t arg)
+{
+    uint32_t index;
+
+    //Claims a slot, retried if an interrupt claimed one in between
+    do
+    {
+        index = __LDREXW(&G8RTOS_TraceHead);
+    }while(__STREXW(index + 1, &G8RTOS_TraceHead));
+
+    traceRecord_t *record = &G8RTOS_TraceRing[index & (TRACE_BUFFER_EVENTS - 1)];
+
+    //A tick that went by but is not counted yet is added here
+    uint32_t ticks = SystemTime;
+    uint32_t count = SysTick->VAL;
+    if(SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
+    {
+        ticks++;
+        count = SysTick->VAL;
+    }
+
+    record->ticks = ticks;
+    record->countAndType = (type << 24) | count;
+    record->arg = arg;
+}
+
+/*
+ * Trace thread, added by G8RTOS_Launch at TRACE_PRIORITY
+ *  - Sends the ring over the back channel UART, sleeps when it is empty
+ */
+void G8RTOS_TraceThread(void);
+
+/*********************************************** Public Functions *********************************************************************/
+
+#define G8RTOS_TRACE(type, arg) G8RTOS_TraceRecord((type), (uint32_t)(uintptr_t)(arg))
+
+#else
+
+#define G8RTOS_TRACE(type, arg)
+
+#endif
+
+#endif /* G8RTOS_TRACE_H_ */
@@ -0,0 +1,69 @@
+/*
+ * BSP.h
+ *
+ * Host stand-in for the board support package
+ *  - Sensors return made up readings that wander slowly, from a fixed seed so runs repeat
+ *  - LED writes are kept in HostBSP_Leds
+ */
+
+#ifndef HOST_BSP_H_
+#define HOST_BSP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************************************** Defines ******************************************************************************/
+
+#define SUCCESS 0
+#define ERROR -1
+
+/*********************************************** Defines ******************************************************************************/
+
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+typedef enum
+{
+    BLUE = 0,
+    GREEN = 1,
+    RED = 2
+}unit_desig;
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+
+/*********************************************** Public Variables *********************************************************************/
+
+/* Last value written to each LP3943 */
+extern uint16_t HostBSP_Leds[3];
+
+/*********************************************** Public Variables *********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/* Initializes the entire board */
+void BSP_InitBoard();
+
+/* Core clock frequency in Hz */
+uint32_t ClockSys_GetSysFreq();
+
+/* Busy waits, like the board's DelayMs */
+void DelayMs(uint32_t ulClockMS);
+
+/* BME280 temperature, the uncompensated reading is already in hundredths of a degree Celsius */
+int8_t bme280_read_uncomp_temperature(int32_t *v_uncomp_temperature_s32);
+int32_t bme280_compensate_temperature_int32(int32_t v_uncomp_temperature_s32);
+
+/* OPT3001 light sensor */
+bool sensorOpt3001Read(uint16_t *rawData);
+
+/* Joystick */
+void GetJoystickCoordinates(int16_t *x_coord, int16_t *y_coord);
+
+/* LP3943 LED drivers */
+void LP3943_LedModeSet(uint32_t unit, uint16_t LED_DATA);
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif /* HOST_BSP_H_ */
@@ -0,0 +1,619 @@
+/*
+ * G8RTOS_Port_Linux.c
+ *
+ * Runs G8RTOS and the application as one Linux process, in place of the Cortex-M4 assembly and SysTick
+ *  - Threads are ucontexts on host sized stacks, the stack arena is still carved so its bookkeeping matches the board
+ *  - Interrupts are a flag, a tick that finds them disabled stays pending like an NVIC pending bit
+ *  - The tick is a POSIX timer raising SIGALRM every SysTick period, one host cycle is one nanosecond
+ *
+ * Simulation, built with G8RTOS_SIM as well:
+ *  - Time is a virtual clock of HOST_CLOCK_HZ cycles that only moves when a thread waits for an interrupt or calls DelayMs,
+ *    it then jumps straight to the next SysTick or queued event, so idle time costs nothing
+ *  - SysTick is a down counter on the virtual clock that the kernel can stop and reload, so tickless idle runs as on the board
+ *  - Threads and handlers run in zero virtual time, a thread that spins without waiting never lets time move
+ *  - No signals are used, so a run is the same every time
+ *  - The run ends after HOST_SIM_SECONDS of virtual time
+ *
+ * Build from the repository root:
+ *  gcc -std=gnu99 -O2 -fcommon -DG8RTOS_HOST -IHostPort -IG8RTOS -I. \
+ *      G8RTOS/G8RTOS_*.c HostPort/HostBSP.c HostPort/G8RTOS_Port_Linux.c main.c threads.c -o g8rtos_host -lrt
+ * Simulation adds -DG8RTOS_SIM and optionally -DHOST_SIM_SECONDS=<seconds>
+ */
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+#include <ucontext.h>
+#include "msp.h"
+#include "G8RTOS.h"
+
+/*
+ * Kernel entry points the board reaches through the vector table
+ */
+extern void G8RTOS_Scheduler();
+extern void SysTick_Handler();
+
+/*
+ * Pointer to the currently running Thread Control Block
+ */
+extern tcb_t * CurrentlyRunningThread;
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+
+/*********************************************** Defines ******************************************************************************/
+
+/* Host stack of every thread, glibc calls and signal frames need far more than a board stack */
+#define HOST_STACKSIZE (256 * 1024)
+
+/* Virtual time a simulation runs for, one day unless given */
+#ifndef HOST_SIM_SECONDS
+#define HOST_SIM_SECONDS 86400
+#endif
+
+/* Events the simulation can have queued at once */
+#define SIM_MAX_EVENTS 8
+
+/* Exception numbers reported in ICSR while a handler runs */
+#define PENDSV_EXCEPTION (PendSV_IRQn + 16)
+#define SYSTICK_EXCEPTION (SysTick_IRQn + 16)
+
+/*********************************************** Defines ******************************************************************************/
+
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+/* Host Context
+ *	- Saved registers and stack of one thread, a thread control block's sp points at it
+ */
+typedef struct hostContext_t
+{
+    ucontext_t context; //Saved by swapcontext when the thread is switched out
+    tcb_t *owner; //Thread control block this context belongs to, 0 if never used
+    void (*entry)(void); //Thread function
+    void (*exit)(void); //Function the thread ends in if its function returns
+}hostContext_t;
+
+static hostContext_t HostContexts[MAX_THREADS];
+static uint8_t HostStacks[MAX_THREADS][HOST_STACKSIZE];
+
+#ifdef G8RTOS_SIM
+/* Simulation Event
+ *	- Something that happens at a virtual time, kept in a min-heap on time
+ */
+typedef struct simEvent_t
+{
+    uint64_t time; //Virtual time the event fires at, in cycles
+    void (*fire)(void); //Called with VirtualTime set to time
+}simEvent_t;
+
+static simEvent_t SimEvents[SIM_MAX_EVENTS];
+static uint32_t NumberOfSimEvents;
+#endif
+
+/*********************************************** Data Structures Used *****************************************************************/
+
+
+/*********************************************** Public Variables *********************************************************************/
+
+CoreDebug_Type HostPort_CoreDebug;
+DIO_PORT_Type HostPort_P1, HostPort_P2, HostPort_P3, HostPort_P4, HostPort_P5;
+volatile uint8_t HostPort_BitBandSink;
+volatile uint32_t HostPort_ExclusiveValue;
+
+/*********************************************** Public Variables *********************************************************************/
+
+
+/*********************************************** Private Variables ********************************************************************/
+
+/* Register images handed out by HostPort_SCB, HostPort_SysTick and HostPort_DWT */
+static SCB_Type HostSCB;
+static SysTick_Type HostSysTick;
+static DWT_Type HostDWT;
+
+/* PRIMASK, interrupts stay disabled until the first thread starts */
+static volatile sig_atomic_t InterruptsDisabled = 1;
+
+/* Pending bits of SysTick and PendSV */
+static volatile sig_atomic_t TickPending;
+static volatile sig_atomic_t PendSVPending;
+
+/* Exception number of the handler running now, 0 in a thread */
+static volatile sig_atomic_t ActiveException;
+
+/* Host time when SysTick started */
+static uint64_t StartTime;
+
+#ifdef G8RTOS_SIM
+/* Virtual clock in cycles, host time in nanoseconds when the simulation started */
+static uint64_t VirtualTime;
+static uint64_t SimStartTime;
+
+/* SysTick counter, NextTickTime is when it next reaches zero while enabled, FrozenCount is its value while stopped */
+static uint64_t NextTickTime;
+static uint32_t FrozenCount;
+
+/* CTRL and VAL as last handed out, a difference on the next access is a write by the kernel */
+static uint32_t PublishedCtrl;
+static uint32_t PublishedVal;
+#else
+/* SysTick period in nanoseconds, host time of the last tick */
+static uint32_t TickPeriod;
+static volatile uint64_t LastTickTime;
+
+/* POSIX timer behind SysTick */
+static timer_t TickTimer;
+#endif
+
+/*********************************************** Private Variables ********************************************************************/
+
+
+/*********************************************** Private Functions ********************************************************************/
+
+/*
+ * Monotonic host time in nanoseconds
+ */
+static uint64_t RealTime(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/*
+ * Time the kernel sees through SysTick and DWT, in cycles
+ */
+static inline uint64_t HostTime(void)
+{
+#ifdef G8RTOS_SIM
+    return VirtualTime;
+#else
+    return RealTime();
+#endif
+}
+
+/*
+ * Switches to the thread the scheduler picks, what PendSV_Handler does on the board
+ */
+static void ContextSwitch(void)
+{
+    tcb_t *previous = CurrentlyRunningThread;
+
+    G8RTOS_Scheduler();
+
+    if(CurrentlyRunningThread != previous)
+    {
+        swapcontext(&((hostContext_t *)previous->sp)->context, &((hostContext_t *)CurrentlyRunningThread->sp)->context);
+    }
+}
+
+/*
+ * Takes pending exceptions while interrupts are enabled, SysTick before PendSV like their priorities on the board
+ *  - Handlers run with interrupts disabled, so a tick arriving meanwhile is taken on the next pass
+ */
+static void Dispatch(void)
+{
+    while(TickPending || PendSVPending)
+    {
+        InterruptsDisabled = 1;
+
+        if(TickPending)
+        {
+            TickPending = 0;
+            ActiveException = SYSTICK_EXCEPTION;
+            SysTick_Handler();
+            ActiveException = 0;
+        }
+
+        if(PendSVPending)
+        {
+            PendSVPending = 0;
+            ActiveException = PENDSV_EXCEPTION;
+            ContextSwitch();
+            ActiveException = 0;
+        }
+
+        InterruptsDisabled = 0;
+    }
+}
+
+/*
+ * SysTick interrupt, taken right away unless interrupts are disabled
+ */
+static void Tick(void)
+{
+    TickPending = 1;
+
+    if(!InterruptsDisabled)
+    {
+        Dispatch();
+    }
+}
+
+#ifdef G8RTOS_SIM
+/*
+ * Adds an event to the simulation's event queue
+ * Param "time": virtual time the event fires at
+ * Param "fire": function called when it fires
+ */
+static void SimSchedule(uint64_t time, void (*fire)(void))
+{
+    uint32_t index = NumberOfSimEvents++;
+
+    //Moves later events down until the new one is in its place
+    while(index != 0 && SimEvents[(index - 1) / 2].time > time)
+    {
+        SimEvents[index] = SimEvents[(index - 1) / 2];
+        index = (index - 1) / 2;
+    }
+    SimEvents[index].time = time;
+    SimEvents[index].fire = fire;
+}
+
+/*
+ * Takes the earliest event off the simulation's event queue
+ * Returns: The event
+ */
+static simEvent_t SimNextEvent(void)
+{
+    simEvent_t first = SimEvents[0];
+    simEvent_t last = SimEvents[--NumberOfSimEvents];
+    uint32_t index = 0;
+
+    //Moves the last event down from the top to its place
+    while(2 * index + 1 < NumberOfSimEvents)
+    {
+        uint32_t child = 2 * index + 1;
+        if(child + 1 < NumberOfSimEvents && SimEvents[child + 1].time < SimEvents[child].time)
+        {
+            child++;
+        }
+        if(last.time <= SimEvents[child].time)
+        {
+            break;
+        }
+        SimEvents[index] = SimEvents[child];
+        index = child;
+    }
+    SimEvents[index] = last;
+
+    return first;
+}
+
+/*
+ * Applies what the kernel wrote to the SysTick image since it was last handed out, then refreshes the image
+ *  - Any write to VAL clears the counter, so the next count starts from LOAD
+ *  - Clearing ENABLE stops the counter where it is, setting it carries on from there
+ *  - LOAD is only read when the counter reloads, so writes to it need nothing here
+ */
+static void SimSyncSysTick(void)
+{
+    bool enabled = PublishedCtrl & SysTick_CTRL_ENABLE_Msk;
+
+    if(HostSysTick.VAL != PublishedVal)
+    {
+        FrozenCount = 0;
+        NextTickTime = VirtualTime + HostSysTick.LOAD + 1;
+    }
+
+    if((HostSysTick.CTRL ^ PublishedCtrl) & SysTick_CTRL_ENABLE_Msk)
+    {
+        enabled = HostSysTick.CTRL & SysTick_CTRL_ENABLE_Msk;
+        if(enabled)
+        {
+            NextTickTime = VirtualTime + (FrozenCount != 0 ? FrozenCount + 1 : HostSysTick.LOAD + 1);
+        }
+        else
+        {
+            FrozenCount = NextTickTime - 1 - VirtualTime;
+        }
+    }
+
+    HostSysTick.VAL = enabled ? NextTickTime - 1 - VirtualTime : FrozenCount;
+    PublishedCtrl = HostSysTick.CTRL;
+    PublishedVal = HostSysTick.VAL;
+}
+
+/*
+ * Moves virtual time forward, firing every SysTick and event due on the way
+ *  - A tick may switch threads, this thread carries on from wherever time is when it runs again
+ * Param "until": virtual time to move to
+ */
+static void SimAdvance(uint64_t until)
+{
+    while(1)
+    {
+        SimSyncSysTick();
+
+        bool tickDue = (HostSysTick.CTRL & SysTick_CTRL_ENABLE_Msk) && NextTickTime <= until;
+        bool eventDue = NumberOfSimEvents != 0 && SimEvents[0].time <= until && (!tickDue || SimEvents[0].time < NextTickTime);
+
+        if(eventDue)
+        {
+            simEvent_t event = SimNextEvent();
+            VirtualTime = event.time;
+            event.fire();
+        }
+        else if(tickDue)
+        {
+            //Counter reaches zero and reloads
+            VirtualTime = NextTickTime;
+            NextTickTime += HostSysTick.LOAD + 1;
+            if(HostSysTick.CTRL & SysTick_CTRL_TICKINT_Msk)
+            {
+                Tick();
+            }
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if(VirtualTime < until)
+    {
+        VirtualTime = until;
+    }
+}
+
+/*
+ * Ends a simulation
+ */
+static void SimStop(void)
+{
+    fprintf(stderr, "Simulated %llu s in %.3f s\n", (unsigned long long)(VirtualTime / HOST_CLOCK_HZ), (RealTime() - SimStartTime) / 1e9);
+    exit(EXIT_SUCCESS);
+}
+#else
+/*
+ * SIGALRM handler, the SysTick interrupt
+ */
+static void TickSignal(int signal)
+{
+    (void)signal;
+
+    LastTickTime = HostTime();
+    Tick();
+}
+#endif
+
+/*
+ * First code run by every thread
+ *  - Leaves the exception it was switched to from with interrupts enabled, like the exception return on the board
+ */
+static void ThreadStart(void)
+{
+    hostContext_t *slot = (hostContext_t *)CurrentlyRunningThread->sp;
+
+    ActiveException = 0;
+    InterruptsDisabled = 0;
+    Dispatch();
+
+    slot->entry();
+    slot->exit();
+}
+
+/*********************************************** Private Functions ********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Register images, refreshed on every access so the kernel reads live values
+ */
+SCB_Type *HostPort_SCB(void)
+{
+#ifdef G8RTOS_SIM
+    SimSyncSysTick();
+#endif
+    HostSCB.ICSR = (TickPending ? SCB_ICSR_PENDSTSET_Msk : 0) | (PendSVPending ? SCB_ICSR_PENDSVSET_Msk : 0) | ActiveException;
+    return &HostSCB;
+}
+
+SysTick_Type *HostPort_SysTick(void)
+{
+#ifdef G8RTOS_SIM
+    SimSyncSysTick();
+#else
+    uint64_t elapsed = HostTime() - LastTickTime;
+    HostSysTick.VAL = (elapsed >= TickPeriod) ? 0 : TickPeriod - 1 - (uint32_t)elapsed;
+#endif
+    return &HostSysTick;
+}
+
+DWT_Type *HostPort_DWT(void)
+{
+    HostDWT.CYCCNT = (uint32_t)(HostTime() - StartTime);
+    return &HostDWT;
+}
+
+/*
+ * Starts SysTick, the tick fires every "ticks" cycles
+ * Returns: 0 on success
+ */
+uint32_t SysTick_Config(uint32_t ticks)
+{
+    StartTime = HostTime();
+    HostSysTick.LOAD = ticks - 1;
+    HostSysTick.CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+
+#ifdef G8RTOS_SIM
+    SimStartTime = RealTime();
+    SimSchedule(VirtualTime + HOST_SIM_SECONDS * (uint64_t)HOST_CLOCK_HZ, SimStop);
+
+    //Counter starts from LOAD, like the board's SysTick_Config
+    PublishedCtrl = HostSysTick.CTRL;
+    NextTickTime = VirtualTime + ticks;
+    SimSyncSysTick();
+#else
+    TickPeriod = ticks;
+    LastTickTime = StartTime;
+
+    struct sigaction action = {0};
+    action.sa_handler = TickSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGALRM, &action, 0);
+
+    struct sigevent event = {0};
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo = SIGALRM;
+    if(timer_create(CLOCK_MONOTONIC, &event, &TickTimer) != 0)
+    {
+        perror("timer_create");
+        exit(EXIT_FAILURE);
+    }
+
+    struct itimerspec period = {0};
+    period.it_interval.tv_sec = ticks / 1000000000;
+    period.it_interval.tv_nsec = ticks % 1000000000;
+    period.it_value = period.it_interval;
+    timer_settime(TickTimer, 0, &period, 0);
+#endif
+
+    return 0;
+}
+
+/*
+ * WFI, waits for a tick even with interrupts disabled
+ *  - The tick signal is blocked while checking, so one that arrives just before the wait still ends it
+ *  - A simulation jumps straight to the next tick or event instead
+ */
+void HostPort_WaitForInterrupt(void)
+{
+#ifdef G8RTOS_SIM
+    SimSyncSysTick();
+    if(!TickPending)
+    {
+        uint64_t next = (HostSysTick.CTRL & SysTick_CTRL_ENABLE_Msk) ? NextTickTime : UINT64_MAX;
+        if(NumberOfSimEvents != 0 && SimEvents[0].time < next)
+        {
+            next = SimEvents[0].time;
+        }
+        SimAdvance(next);
+    }
+#else
+    sigset_t tick, previous;
+    sigemptyset(&tick);
+    sigaddset(&tick, SIGALRM);
+    sigprocmask(SIG_BLOCK, &tick, &previous);
+
+    if(!TickPending)
+    {
+        sigset_t wait = previous;
+        sigdelset(&wait, SIGALRM);
+        sigsuspend(&wait);
+    }
+
+    sigprocmask(SIG_SETMASK, &previous, 0);
+#endif
+}
+
+/*
+ * Busy waits, interrupts that come meanwhile are taken if enabled
+ * Param "ns": nanoseconds to wait
+ */
+void HostPort_Delay(uint64_t ns)
+{
+#ifdef G8RTOS_SIM
+    uint64_t until = VirtualTime + ns * HOST_CLOCK_HZ / 1000000000ULL;
+    while(VirtualTime < until)
+    {
+        SimAdvance(until);
+    }
+#else
+    struct timespec delay = { ns / 1000000000ULL, ns % 1000000000ULL };
+
+    //Ticks interrupt the sleep, the rest of it is slept after they return
+    while(nanosleep(&delay, &delay) != 0 && errno == EINTR);
+#endif
+}
+
+/*
+ * Requests a context switch, taken right away unless interrupts are disabled or a tick is being handled
+ */
+void HostPort_PendSV(void)
+{
+    PendSVPending = 1;
+
+    if(!InterruptsDisabled)
+    {
+        Dispatch();
+    }
+}
+
+/*
+ * Starts a critical section
+ * Returns: The current PRIMASK State
+ */
+int32_t StartCriticalSection()
+{
+    int32_t state = InterruptsDisabled;
+    InterruptsDisabled = 1;
+    return state;
+}
+
+/*
+ * Ends a critical Section, pending exceptions are taken once interrupts are enabled again
+ * Param "IBit_State": PRIMASK State to update
+ */
+void EndCriticalSection(int32_t IBit_State)
+{
+    InterruptsDisabled = IBit_State;
+
+    if(!IBit_State)
+    {
+        Dispatch();
+    }
+}
+
+/*
+ * Builds the first context of a new thread, so the first switch to it starts "entry"
+ *  - Every thread control block keeps the same host context and stack for its whole life
+ * Param "thread": thread control block of the new thread, its sp is set here
+ * Param "stackTop": stack carved from the arena, not used on the host
+ * Param "entry": thread function
+ * Param "exit": function the thread ends in if "entry" returns
+ */
+void G8RTOS_PortInitContext(tcb_t *thread, int32_t *stackTop, void (*entry)(void), void (*exit)(void))
+{
+    hostContext_t *slot = 0;
+    (void)stackTop;
+
+    for(uint32_t i = 0; i < MAX_THREADS && slot == 0; i++)
+    {
+        if(HostContexts[i].owner == thread || HostContexts[i].owner == 0)
+        {
+            slot = &HostContexts[i];
+        }
+    }
+
+    slot->owner = thread;
+    slot->entry = entry;
+    slot->exit = exit;
+
+    getcontext(&slot->context);
+    slot->context.uc_stack.ss_sp = HostStacks[slot - HostContexts];
+    slot->context.uc_stack.ss_size = HOST_STACKSIZE;
+    slot->context.uc_link = 0;
+    sigemptyset(&slot->context.uc_sigmask);
+    makecontext(&slot->context, ThreadStart, 0);
+
+    thread->sp = (int32_t *)slot;
+}
+
+/*
+ * Starts the first thread, what G8RTOS_Start in G8RTOS_SchedulerASM.s does on the board
+ */
+void G8RTOS_Start()
+{
+    setcontext(&((hostContext_t *)CurrentlyRunningThread->sp)->context);
+}
+
+/*********************************************** Public Functions *********************************************************************/
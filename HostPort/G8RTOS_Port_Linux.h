@@ -0,0 +1,21 @@
+/*
+ * G8RTOS_Port_Linux.h
+ *
+ * Linux port of G8RTOS, included by G8RTOS_Port.h when building with G8RTOS_HOST
+ */
+
+#ifndef G8RTOS_PORT_LINUX_H_
+#define G8RTOS_PORT_LINUX_H_
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Requests a context switch, taken right away unless interrupts are disabled or a tick is being handled
+ */
+void HostPort_PendSV(void);
+
+#define G8RTOS_PendSV() HostPort_PendSV()
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif /* G8RTOS_PORT_LINUX_H_ */
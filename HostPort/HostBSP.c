@@ -0,0 +1,151 @@
+/*
+ * HostBSP.c
+ *
+ * Host stand-in for the board support package and the back channel UART
+ */
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include "msp.h"
+#include "driverlib.h"
+#include "BSP.h"
+#include "G8RTOS_CriticalSection.h"
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+
+/*********************************************** Public Variables *********************************************************************/
+
+/* Last value written to each LP3943 */
+uint16_t HostBSP_Leds[3];
+
+/*********************************************** Public Variables *********************************************************************/
+
+
+/*********************************************** Private Variables ********************************************************************/
+
+/* State of the pseudo random sensor readings, fixed so runs repeat */
+static uint32_t SensorSeed = 0x2545F491;
+
+/* Current sensor readings */
+static int32_t Temperature = 2300;
+static int32_t Light = 3000;
+static int32_t JoystickX = 0;
+static int32_t JoystickY = 0;
+
+/*********************************************** Private Variables ********************************************************************/
+
+
+/*********************************************** Private Functions ********************************************************************/
+
+/*
+ * Moves a reading by a random step and keeps it in range
+ * Param "value": reading to move
+ * Param "step": largest step either way
+ * Param "min", "max": range of the reading
+ */
+static int32_t Wander(int32_t value, int32_t step, int32_t min, int32_t max)
+{
+    //xorshift32
+    SensorSeed ^= SensorSeed << 13;
+    SensorSeed ^= SensorSeed >> 17;
+    SensorSeed ^= SensorSeed << 5;
+
+    value += (int32_t)(SensorSeed % (2 * step + 1)) - step;
+    if(value < min)
+    {
+        value = min;
+    }
+    if(value > max)
+    {
+        value = max;
+    }
+    return value;
+}
+
+/*********************************************** Private Functions ********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/* Initializes the entire board */
+void BSP_InitBoard()
+{
+    //Lines printed over the back channel show up as they are written
+    setvbuf(stdout, 0, _IOLBF, 0);
+}
+
+/* Core clock frequency in Hz */
+uint32_t ClockSys_GetSysFreq()
+{
+    return HOST_CLOCK_HZ;
+}
+
+/* Busy waits, like the board's DelayMs, on the virtual clock in a simulation */
+void DelayMs(uint32_t ulClockMS)
+{
+    HostPort_Delay(ulClockMS * 1000000ULL);
+}
+
+/* BME280 temperature, the uncompensated reading is already in hundredths of a degree Celsius */
+int8_t bme280_read_uncomp_temperature(int32_t *v_uncomp_temperature_s32)
+{
+    int32_t priMask = StartCriticalSection();
+    Temperature = Wander(Temperature, 20, 1500, 3000);
+    *v_uncomp_temperature_s32 = Temperature;
+    EndCriticalSection(priMask);
+    return SUCCESS;
+}
+
+int32_t bme280_compensate_temperature_int32(int32_t v_uncomp_temperature_s32)
+{
+    return v_uncomp_temperature_s32;
+}
+
+/* OPT3001 light sensor */
+bool sensorOpt3001Read(uint16_t *rawData)
+{
+    int32_t priMask = StartCriticalSection();
+    Light = Wander(Light, 500, 0, 20000);
+    *rawData = (uint16_t)Light;
+    EndCriticalSection(priMask);
+    return true;
+}
+
+/* Joystick */
+void GetJoystickCoordinates(int16_t *x_coord, int16_t *y_coord)
+{
+    int32_t priMask = StartCriticalSection();
+    JoystickX = Wander(JoystickX, 1000, -8192, 8191);
+    JoystickY = Wander(JoystickY, 1000, -8192, 8191);
+    *x_coord = (int16_t)JoystickX;
+    *y_coord = (int16_t)JoystickY;
+    EndCriticalSection(priMask);
+}
+
+/* LP3943 LED drivers */
+void LP3943_LedModeSet(uint32_t unit, uint16_t LED_DATA)
+{
+    if(unit <= RED)
+    {
+        HostBSP_Leds[unit] = LED_DATA;
+    }
+}
+
+/*
+ * Sends one byte over a UART, the back channel UART goes to stdout
+ *  - stdio is not safe to enter twice from the same process thread, so no switch happens inside it
+ */
+void MAP_UART_transmitData(uint32_t moduleInstance, uint_fast8_t transmitData)
+{
+    int32_t priMask = StartCriticalSection();
+    if(moduleInstance == EUSCI_A0_BASE)
+    {
+        putchar(transmitData);
+    }
+    EndCriticalSection(priMask);
+}
+
+/*********************************************** Public Functions *********************************************************************/
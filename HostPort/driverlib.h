@@ -0,0 +1,68 @@
+/*
+ * driverlib.h
+ *
+ * Host stand-in for the MSP432 DriverLib, only what the application and kernel use
+ *  - The back channel UART writes to stdout
+ *  - Pin and clock setup does nothing
+ */
+
+#ifndef HOST_DRIVERLIB_H_
+#define HOST_DRIVERLIB_H_
+
+#include <stdint.h>
+#include "msp.h"
+
+/*********************************************** Defines ******************************************************************************/
+
+#define EUSCI_A0_BASE 0x40001000
+
+#define EUSCI_A_UART_CLOCKSOURCE_SMCLK 0x80
+#define EUSCI_A_UART_NO_PARITY 0x00
+#define EUSCI_A_UART_LSB_FIRST 0x00
+#define EUSCI_A_UART_ONE_STOP_BIT 0x00
+#define EUSCI_A_UART_MODE 0x00
+#define EUSCI_A_UART_OVERSAMPLING_BAUDRATE_GENERATION 0x01
+
+#define GPIO_PORT_P1 1
+#define GPIO_PIN2 0x0004
+#define GPIO_PIN3 0x0008
+#define GPIO_PRIMARY_MODULE_FUNCTION 0x01
+
+#define CS_DCO_FREQUENCY_12 12000000
+
+/*********************************************** Defines ******************************************************************************/
+
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+typedef struct _eUSCI_eUSCI_UART_Config
+{
+    uint_fast8_t selectClockSource;
+    uint_fast16_t clockPrescalar;
+    uint_fast8_t firstModReg;
+    uint_fast8_t secondModReg;
+    uint_fast8_t parity;
+    uint_fast16_t msborLsbFirst;
+    uint_fast16_t numberofStopBits;
+    uint_fast16_t uartMode;
+    uint_fast8_t overSampling;
+} eUSCI_UART_Config;
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+/*
+ * Sends one byte over a UART, the back channel UART goes to stdout
+ */
+void MAP_UART_transmitData(uint32_t moduleInstance, uint_fast8_t transmitData);
+
+#define MAP_UART_initModule(moduleInstance, config) ((void)(moduleInstance), (void)(config))
+#define MAP_UART_enableModule(moduleInstance) ((void)(moduleInstance))
+#define MAP_GPIO_setAsPeripheralModuleFunctionInputPin(port, pins, mode) ((void)(port), (void)(pins), (void)(mode))
+#define CS_setDCOCenteredFrequency(frequency) ((void)(frequency))
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif /* HOST_DRIVERLIB_H_ */
@@ -0,0 +1,155 @@
+/*
+ * msp.h
+ *
+ * Host stand-in for the MSP432 device header, used by the Linux port
+ *  - Core registers the kernel reads are refreshed from the port on every access
+ *  - SysTick counts in nanoseconds, the host core clock is HOST_CLOCK_HZ
+ */
+
+#ifndef HOST_MSP_H_
+#define HOST_MSP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************************************** Defines ******************************************************************************/
+
+/* Host core clock, one cycle is one nanosecond, a simulation counts virtual cycles of the board's clock */
+#ifdef G8RTOS_SIM
+#define HOST_CLOCK_HZ 48000000
+#else
+#define HOST_CLOCK_HZ 1000000000
+#endif
+
+#define BIT0 0x01
+#define BIT1 0x02
+#define BIT2 0x04
+#define BIT3 0x08
+#define BIT4 0x10
+#define BIT5 0x20
+#define BIT6 0x40
+#define BIT7 0x80
+
+#define SCB_ICSR_PENDSVSET_Msk (1UL << 28)
+#define SCB_ICSR_PENDSTSET_Msk (1UL << 26)
+#define SCB_ICSR_VECTACTIVE_Msk 0x1FFUL
+#define SysTick_CTRL_ENABLE_Msk (1UL << 0)
+#define SysTick_CTRL_TICKINT_Msk (1UL << 1)
+#define SysTick_CTRL_CLKSOURCE_Msk (1UL << 2)
+#define SysTick_CTRL_COUNTFLAG_Msk (1UL << 16)
+#define SysTick_LOAD_RELOAD_Msk 0xFFFFFFUL
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+/* No FPU context to manage on the host */
+#define __FPU_USED 0
+
+/*********************************************** Defines ******************************************************************************/
+
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+typedef enum
+{
+    PendSV_IRQn = -2,
+    SysTick_IRQn = -1
+}IRQn_Type;
+
+typedef struct
+{
+    volatile uint32_t ICSR;
+}SCB_Type;
+
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t LOAD;
+    volatile uint32_t VAL;
+    volatile uint32_t CALIB;
+}SysTick_Type;
+
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+}DWT_Type;
+
+typedef struct
+{
+    volatile uint32_t DEMCR;
+}CoreDebug_Type;
+
+typedef struct
+{
+    volatile uint8_t OUT;
+    volatile uint8_t DIR;
+}DIO_PORT_Type;
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+
+/*********************************************** Public Variables *********************************************************************/
+
+extern CoreDebug_Type HostPort_CoreDebug;
+extern DIO_PORT_Type HostPort_P1, HostPort_P2, HostPort_P3, HostPort_P4, HostPort_P5;
+extern volatile uint8_t HostPort_BitBandSink;
+extern volatile uint32_t HostPort_ExclusiveValue;
+
+/*********************************************** Public Variables *********************************************************************/
+
+
+/*********************************************** Public Functions *********************************************************************/
+
+SCB_Type *HostPort_SCB(void);
+SysTick_Type *HostPort_SysTick(void);
+DWT_Type *HostPort_DWT(void);
+void HostPort_WaitForInterrupt(void);
+void HostPort_Delay(uint64_t ns);
+uint32_t SysTick_Config(uint32_t ticks);
+
+#define SCB (HostPort_SCB())
+#define SysTick (HostPort_SysTick())
+#define DWT (HostPort_DWT())
+#define CoreDebug (&HostPort_CoreDebug)
+
+#define P1 (&HostPort_P1)
+#define P2 (&HostPort_P2)
+#define P3 (&HostPort_P3)
+#define P4 (&HostPort_P4)
+#define P5 (&HostPort_P5)
+
+/* Bit-band writes only drive LEDs and scope pins on the board, here they go nowhere */
+#define BITBAND_PERI(reg, bit) (HostPort_BitBandSink)
+
+static inline void NVIC_SetPriority(IRQn_Type irq, uint32_t priority)
+{
+    (void)irq;
+    (void)priority;
+}
+
+#define __CLZ(x) ((uint32_t)((x) == 0 ? 32 : __builtin_clz(x)))
+#define __WFI() HostPort_WaitForInterrupt()
+#define __DSB() __atomic_signal_fence(__ATOMIC_SEQ_CST)
+#define __ISB() __atomic_signal_fence(__ATOMIC_SEQ_CST)
+#define __DMB() __atomic_signal_fence(__ATOMIC_SEQ_CST)
+
+/*
+ * Exclusive load and store, the store fails if an interrupt changed the word in between
+ *  - Interrupts are signals on the one host thread, so a compare and swap gives the same guarantee
+ */
+static inline uint32_t __LDREXW(volatile uint32_t *addr)
+{
+    uint32_t value = *addr;
+    HostPort_ExclusiveValue = value;
+    return value;
+}
+
+static inline uint32_t __STREXW(uint32_t value, volatile uint32_t *addr)
+{
+    uint32_t expected = HostPort_ExclusiveValue;
+    return !__atomic_compare_exchange_n(addr, &expected, value, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+/*********************************************** Public Functions *********************************************************************/
+
+#endif /* HOST_MSP_H_ */
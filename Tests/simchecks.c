@@ -0,0 +1,347 @@
+/*
+ * simchecks.c
+ *
+ * Kernel checks run in the host port's virtual-time simulator, built in place of main.c and threads.c
+ *  - Prints one CSV row per check over the back channel UART, so a run shows what passed and what did not
+ *  - Virtual time makes every run the same, so a failing check always fails the same way
+ *  - Exits with a failure status if any check failed
+ *
+ * Host build from the repository root:
+ *  gcc -std=gnu99 -O2 -fcommon -DG8RTOS_HOST -DG8RTOS_SIM -IHostPort -IG8RTOS -I. \
+ *      G8RTOS/G8RTOS_*.c HostPort/HostBSP.c HostPort/G8RTOS_Port_Linux.c Tests/simchecks.c -o g8rtos_checks -lrt
+ */
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "msp.h"
+#include <driverlib.h>
+#include "BSP.h"
+#include "G8RTOS.h"
+#include "G8RTOS_Tickless.h"
+
+#ifndef G8RTOS_SIM
+#error "The checks rely on virtual time, build them with -DG8RTOS_HOST -DG8RTOS_SIM"
+#endif
+
+/*********************************************** Dependencies and Externs *************************************************************/
+
+
+/*********************************************** Defines ******************************************************************************/
+
+#define CHECK_PERIOD 5 //Period in ms of the periodic events checked
+#define CHECK_STALL 3 //Periods the tick stalls for in the catch-up check
+
+#define TICKLESS_CYCLES 10 //Counter cycles in one tick of the tickless check, small so every wake up point is tried
+#define TICKLESS_TICKS 6 //Most ticks one tickless sleep of the check is stretched over
+
+#define FLAG_WAITERS 4 //Threads blocked on one event flag group at once
+#define FLAG_TIMEOUT 10 //Timeout in ms of the event flag wait that runs out
+
+#define RUNNER_PRIORITY 2 //Above the waiters it starts, below the timer thread
+#define RUNNER_STACKSIZE 1024 //snprintf needs room
+#define WAITER_PRIORITY 3 //Runs once the runner sleeps
+#define EAGER_PRIORITY 1 //Preempts the runner as soon as it is woken
+#define WAITER_STACKSIZE 512
+
+/*********************************************** Defines ******************************************************************************/
+
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+/*
+ * One event flag wait, filled in by the runner and the waiter that makes it
+ */
+typedef struct flagWait_t
+{
+    uint32_t mask; //Flags waited for
+    uint8_t options; //EVENT_FLAGS_ANY or EVENT_FLAGS_ALL, with EVENT_FLAGS_CLEAR
+    uint32_t timeoutMS; //Longest time to wait
+    uint32_t waits; //Waits made one after the other, only the last one records its result
+    volatile bool done; //Set once the waiter is done
+    int32_t result; //What the last wait returned
+    uint32_t flags; //Flags that ended the last wait
+    uint32_t ticks; //Ticks the last wait took
+}flagWait_t;
+
+/*********************************************** Datatype Definitions *****************************************************************/
+
+
+/*********************************************** Private Variables ********************************************************************/
+
+/* Checks that failed so far */
+static uint32_t Failures;
+
+/* Periodic checks, releases the handler ran and the tick of the last one */
+static volatile uint32_t Releases;
+static volatile uint32_t LastRelease;
+
+/* Event flag checks, the group and the waits on it, a waiter takes the next one when it starts */
+static eventFlags_t Flags;
+static flagWait_t FlagWaits[FLAG_WAITERS];
+static uint32_t NextFlagWait;
+
+/*********************************************** Private Variables ********************************************************************/
+
+
+/*********************************************** Private Functions ********************************************************************/
+
+/* method to transmit a string through USART */
+static void uartTransmitString(const char *s)
+{
+    /* Loop while not null */
+    while(*s)
+    {
+        MAP_UART_transmitData(EUSCI_A0_BASE, *s++);
+    }
+}
+
+/*
+ * Prints the row of one check
+ * Param "name": what was checked
+ * Param "passed": whether it held
+ * Param "detail": values seen, for a check that failed
+ */
+static void Report(const char *name, bool passed, const char *detail)
+{
+    char row[128];
+
+    if(!passed)
+    {
+        Failures++;
+    }
+    snprintf(row, sizeof(row), "%s,%s,%s\n\r", name, passed ? "pass" : "FAIL", detail);
+    uartTransmitString(row);
+}
+
+/*
+ * The tickless helpers put the counter's reload on a tick boundary, and a wake up at any cycle before it fires
+ * gives back the boundaries crossed and the cycles to the next one
+ *  - Every phase of the tick the sleep starts at, every length and every cycle it may end at are tried
+ */
+static void CheckTickless(void)
+{
+    char detail[96];
+    uint32_t failures = 0;
+
+    for(uint32_t count = 1; count <= TICKLESS_CYCLES; count++)
+    {
+        for(uint32_t idleTicks = 1; idleTicks <= TICKLESS_TICKS; idleTicks++)
+        {
+            uint32_t reload = Tickless_Reload(idleTicks, TICKLESS_CYCLES, count);
+            failures += reload != count + (idleTicks - 1) * TICKLESS_CYCLES;
+
+            //Tick boundary k is count + k * TICKLESS_CYCLES cycles in, the last one is where the counter fires
+            for(uint32_t cycles = 0; cycles < reload; cycles++)
+            {
+                uint32_t crossed = (cycles < count) ? 0 : (cycles - count) / TICKLESS_CYCLES + 1;
+                uint32_t next = count + crossed * TICKLESS_CYCLES - cycles;
+
+                failures += Tickless_ElapsedTicks(idleTicks, TICKLESS_CYCLES, reload - cycles) != crossed;
+                failures += Tickless_CyclesToNextTick(TICKLESS_CYCLES, reload - cycles) != next;
+            }
+        }
+    }
+
+    //Longest sleep on the board's 24 bit SysTick still fits it
+    uint32_t cyclesPerTick = 48000;
+    uint32_t maxTicks = Tickless_MaxIdleTicks(cyclesPerTick, 0x00FFFFFF);
+    failures += Tickless_Reload(maxTicks, cyclesPerTick, cyclesPerTick) > 0x00FFFFFF;
+    failures += Tickless_Reload(maxTicks + 1, cyclesPerTick, cyclesPerTick) <= 0x00FFFFFF;
+
+    snprintf(detail, sizeof(detail), "mismatches=%lu max_ticks=%lu", (unsigned long)failures, (unsigned long)maxTicks);
+    Report("tickless_helpers", failures == 0, detail);
+}
+
+/*
+ * Periodic handler, counts its releases
+ */
+static void CatchupHandler(void)
+{
+    Releases++;
+    LastRelease = SystemTime;
+}
+
+/*
+ * A catch-up event whose tick stalls for CHECK_STALL periods counts exactly CHECK_STALL missed releases,
+ * and runs every one of them
+ */
+static void CheckCatchup(void)
+{
+    char detail[64];
+    uint32_t period = G8RTOS_MsToTicks(CHECK_PERIOD);
+
+    G8RTOS_AddPeriodicEvent(&CatchupHandler, CHECK_PERIOD, PERIODIC_CATCHUP, PERIODIC_SHORT);
+    while(Releases < 2)
+    {
+        G8RTOS_Sleep(1);
+    }
+
+    //Tick stalls right up to the release CHECK_STALL periods after the next one, which then comes in late
+    int32_t priMask = StartCriticalSection();
+    uint32_t before = Releases;
+    G8RTOS_AdvanceTime(LastRelease + (CHECK_STALL + 1) * period - SystemTime);
+    EndCriticalSection(priMask);
+
+    G8RTOS_Sleep(1);
+
+    uint32_t missed = G8RTOS_GetMissedReleases(&CatchupHandler);
+    uint32_t ran = Releases - before;
+    snprintf(detail, sizeof(detail), "missed=%lu ran=%lu", (unsigned long)missed, (unsigned long)ran);
+    Report("periodic_catchup_missed", missed == CHECK_STALL && ran == CHECK_STALL + 1, detail);
+}
+
+/*
+ * Makes the next event flag wait the runner set up, as many times as it asks for
+ */
+static void FlagWaiter(void)
+{
+    flagWait_t *wait = &FlagWaits[NextFlagWait++];
+
+    for(uint32_t i = 0; i < wait->waits; i++)
+    {
+        uint32_t start = SystemTime;
+        wait->result = G8RTOS_WaitEventFlags(&Flags, wait->mask, wait->options, wait->timeoutMS, &wait->flags);
+        wait->ticks = SystemTime - start;
+    }
+    wait->done = true;
+}
+
+/*
+ * Starts a thread that waits on the event flag group
+ * Param "priority": priority of the thread
+ * Param "mask", "options", "timeoutMS": the wait it makes
+ * Param "waits": times it makes the wait
+ */
+static void StartFlagWaiter(uint8_t priority, uint32_t mask, uint8_t options, uint32_t timeoutMS, uint32_t waits)
+{
+    flagWait_t *wait = &FlagWaits[NextFlagWait];
+
+    wait->mask = mask;
+    wait->options = options;
+    wait->timeoutMS = timeoutMS;
+    wait->waits = waits;
+    wait->done = false;
+    wait->result = SUCCESS;
+    wait->flags = 0;
+    G8RTOS_AddThread(&FlagWaiter, priority, WAITER_STACKSIZE);
+
+    //Lets it block before the next one starts, so they queue in order
+    G8RTOS_Sleep(1);
+}
+
+/*
+ * Empties the event flag group and forgets the waits on it
+ */
+static void ResetFlags(void)
+{
+    G8RTOS_InitEventFlags(&Flags);
+    NextFlagWait = 0;
+}
+
+/*
+ * An any wait ends on one flag of its mask, an all wait only once every flag of it is set
+ */
+static void CheckFlagsAnyAll(void)
+{
+    char detail[96];
+
+    ResetFlags();
+    StartFlagWaiter(WAITER_PRIORITY, 0x3, EVENT_FLAGS_ANY, WAIT_FOREVER, 1);
+    StartFlagWaiter(WAITER_PRIORITY, 0x3, EVENT_FLAGS_ALL, WAIT_FOREVER, 1);
+
+    G8RTOS_SetEventFlags(&Flags, 0x1);
+    G8RTOS_Sleep(1);
+    bool anyFirst = FlagWaits[0].done && FlagWaits[0].flags == 0x1 && !FlagWaits[1].done;
+
+    G8RTOS_SetEventFlags(&Flags, 0x2);
+    G8RTOS_Sleep(1);
+    bool allSecond = FlagWaits[1].done && FlagWaits[1].flags == 0x3;
+
+    snprintf(detail, sizeof(detail), "any=%lx all=%lx set=%lx", (unsigned long)FlagWaits[0].flags,
+             (unsigned long)FlagWaits[1].flags, (unsigned long)G8RTOS_GetEventFlags(&Flags));
+    Report("event_flags_any_all", anyFirst && allSecond && G8RTOS_GetEventFlags(&Flags) == 0x3, detail);
+}
+
+/*
+ * A set wakes every waiter a flag satisfies even when they clear it, and the flag is then cleared,
+ * so a waiter woken first that preempts the set and waits again does not see it a second time
+ */
+static void CheckFlagsClear(void)
+{
+    char detail[96];
+
+    ResetFlags();
+    StartFlagWaiter(EAGER_PRIORITY, 0x4, EVENT_FLAGS_ANY | EVENT_FLAGS_CLEAR, FLAG_TIMEOUT, 2);
+    for(uint32_t i = 1; i < FLAG_WAITERS; i++)
+    {
+        StartFlagWaiter(WAITER_PRIORITY, 0x4, EVENT_FLAGS_ANY | EVENT_FLAGS_CLEAR, WAIT_FOREVER, 1);
+    }
+
+    G8RTOS_SetEventFlags(&Flags, 0x4);
+    G8RTOS_Sleep(2 * FLAG_TIMEOUT);
+
+    uint32_t woken = 0;
+    for(uint32_t i = 1; i < FLAG_WAITERS; i++)
+    {
+        woken += FlagWaits[i].done && FlagWaits[i].result == SUCCESS && FlagWaits[i].flags == 0x4;
+    }
+    bool eagerOnce = FlagWaits[0].done && FlagWaits[0].result == ERROR;
+
+    snprintf(detail, sizeof(detail), "woken=%lu eager=%ld set=%lx", (unsigned long)woken, (long)FlagWaits[0].result,
+             (unsigned long)G8RTOS_GetEventFlags(&Flags));
+    Report("event_flags_clear_wakes_all", woken == FLAG_WAITERS - 1 && eagerOnce && G8RTOS_GetEventFlags(&Flags) == 0, detail);
+}
+
+/*
+ * A wait nothing satisfies ends with an error once its timeout runs out, and not before
+ */
+static void CheckFlagsTimeout(void)
+{
+    char detail[64];
+
+    ResetFlags();
+    StartFlagWaiter(WAITER_PRIORITY, 0x8, EVENT_FLAGS_ANY, FLAG_TIMEOUT, 1);
+    G8RTOS_SetEventFlags(&Flags, 0x1);
+    G8RTOS_Sleep(2 * FLAG_TIMEOUT);
+
+    snprintf(detail, sizeof(detail), "result=%ld ticks=%lu", (long)FlagWaits[0].result, (unsigned long)FlagWaits[0].ticks);
+    Report("event_flags_timeout", FlagWaits[0].done && FlagWaits[0].result == ERROR &&
+           FlagWaits[0].ticks >= G8RTOS_MsToTicks(FLAG_TIMEOUT), detail);
+}
+
+/*
+ * Runs every check and exits with their result
+ */
+static void CheckRunner(void)
+{
+    char row[64];
+
+    uartTransmitString("check,result,detail\n\r");
+
+    CheckTickless();
+    CheckCatchup();
+    CheckFlagsAnyAll();
+    CheckFlagsClear();
+    CheckFlagsTimeout();
+
+    snprintf(row, sizeof(row), "failures,%lu\n\r", (unsigned long)Failures);
+    uartTransmitString(row);
+    exit(Failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/*********************************************** Private Functions ********************************************************************/
+
+
+void main(void)
+{
+    //Initialize G8RTOS
+    G8RTOS_Init();
+
+    while(!(G8RTOS_AddThread(&CheckRunner, RUNNER_PRIORITY, RUNNER_STACKSIZE) + 1));
+
+    //Start GatorOS
+    G8RTOS_Launch();
+}
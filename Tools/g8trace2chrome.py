@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""
+g8trace2chrome.py
+
+Converts a G8RTOS kernel trace, captured from the back channel UART, into Chrome trace JSON
+that opens in Perfetto (ui.perfetto.dev) or chrome://tracing.
+
+Build with KERNEL_TRACE=1, capture the raw serial stream to a file, for example
+    stty -F /dev/ttyACM0 115200 raw && cat /dev/ttyACM0 > capture.bin
+then run
+    python3 g8trace2chrome.py capture.bin trace.json
+
+The stream is a series of batches, see traceBatch_t and traceRecord_t in G8RTOS_Trace.h.
+Anything between batches, such as text printed to the same UART, is skipped.
+"""
+
+import json
+import struct
+import sys
+
+BATCH_MAGIC = 0x52543847
+BATCH = struct.Struct("<IIIHH")
+RECORD = struct.Struct("<III")
+
+#Same order as traceEvent_t
+TRACE_SWITCH = 1
+TRACE_SEM_WAIT = 2
+TRACE_SEM_BLOCK = 3
+TRACE_SEM_SIGNAL = 4
+TRACE_SEM_UNBLOCK = 5
+TRACE_FIFO_READ = 6
+TRACE_FIFO_WRITE = 7
+TRACE_FIFO_DROP = 8
+TRACE_PERIODIC_RELEASE = 9
+TRACE_ISR_ENTER = 10
+TRACE_ISR_EXIT = 11
+TRACE_MUTEX_LOCK = 12
+TRACE_MUTEX_BLOCK = 13
+TRACE_MUTEX_UNLOCK = 14
+TRACE_FLAGS_SET = 15
+TRACE_FLAGS_BLOCK = 16
+TRACE_TOPIC_PUBLISH = 17
+TRACE_TOPIC_LAG = 18
+
+INSTANT_NAMES = {
+    TRACE_SEM_WAIT: "sem wait",
+    TRACE_SEM_BLOCK: "sem block",
+    TRACE_SEM_SIGNAL: "sem signal",
+    TRACE_SEM_UNBLOCK: "sem unblock",
+    TRACE_FIFO_READ: "fifo read",
+    TRACE_FIFO_WRITE: "fifo write",
+    TRACE_FIFO_DROP: "fifo drop",
+    TRACE_PERIODIC_RELEASE: "periodic release",
+    TRACE_MUTEX_LOCK: "mutex lock",
+    TRACE_MUTEX_BLOCK: "mutex block",
+    TRACE_MUTEX_UNLOCK: "mutex unlock",
+    TRACE_FLAGS_SET: "flags set",
+    TRACE_FLAGS_BLOCK: "flags block",
+    TRACE_TOPIC_PUBLISH: "topic publish",
+    TRACE_TOPIC_LAG: "topic lag",
+}
+
+ISR_TID = "interrupts"
+
+
+def read_batches(data):
+    """Yields (header, records) for every batch found in the stream"""
+    magic = struct.pack("<I", BATCH_MAGIC)
+    pos = data.find(magic)
+    while pos >= 0 and pos + BATCH.size <= len(data):
+        _, clk_freq, cycles_per_tick, count, lost = BATCH.unpack_from(data, pos)
+        end = pos + BATCH.size + count * RECORD.size
+        if end > len(data):
+            break
+        records = [RECORD.unpack_from(data, pos + BATCH.size + i * RECORD.size) for i in range(count)]
+        yield (clk_freq, cycles_per_tick, lost), records
+        pos = data.find(magic, end)
+
+
+def convert(data):
+    """Returns the Chrome trace event list for a captured stream"""
+    events = []
+    timed = []
+    clk_freq = None
+
+    for (freq, cycles_per_tick, lost), records in read_batches(data):
+        clk_freq = freq
+        for ticks, count_and_type, arg in records:
+            count = count_and_type & 0xFFFFFF
+            kind = count_and_type >> 24
+            cycles = ticks * cycles_per_tick + (cycles_per_tick - 1 - count)
+            timed.append((cycles, kind, arg))
+        if lost:
+            #Marked at the first record after the gap
+            if records:
+                first = records[0]
+                cycles = first[0] * cycles_per_tick + (cycles_per_tick - 1 - (first[1] & 0xFFFFFF))
+                timed.append((cycles, 0, lost))
+
+    if clk_freq is None:
+        return events
+
+    #Records are claimed before they are stamped, so an interrupt can leave them slightly out of order
+    timed.sort(key=lambda e: e[0])
+
+    def us(cycles):
+        return cycles * 1e6 / clk_freq
+
+    thread = None
+    thread_start = None
+    isr_start = {}
+
+    for cycles, kind, arg in timed:
+        ts = us(cycles)
+        if kind == TRACE_SWITCH:
+            if thread is not None:
+                events.append({"name": "thread 0x%x" % thread, "ph": "X", "pid": 0, "tid": "thread 0x%x" % thread,
+                               "ts": thread_start, "dur": ts - thread_start})
+            thread = arg
+            thread_start = ts
+        elif kind == TRACE_ISR_ENTER:
+            isr_start.setdefault(arg, []).append(ts)
+        elif kind == TRACE_ISR_EXIT:
+            starts = isr_start.get(arg)
+            if starts:
+                start = starts.pop()
+                events.append({"name": "exception %d" % arg, "ph": "X", "pid": 0, "tid": ISR_TID,
+                               "ts": start, "dur": ts - start})
+        elif kind in INSTANT_NAMES:
+            tid = "thread 0x%x" % thread if thread is not None else ISR_TID
+            events.append({"name": INSTANT_NAMES[kind], "ph": "i", "s": "t", "pid": 0, "tid": tid,
+                           "ts": ts, "args": {"arg": "0x%x" % arg}})
+        elif kind == 0:
+            events.append({"name": "%d records lost" % arg, "ph": "i", "s": "g", "pid": 0, "tid": ISR_TID,
+                           "ts": ts})
+
+    return events
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.stderr.write("usage: g8trace2chrome.py capture.bin trace.json\n")
+        return 1
+
+    with open(sys.argv[1], "rb") as f:
+        data = f.read()
+
+    events = convert(data)
+    with open(sys.argv[2], "w") as f:
+        json.dump({"traceEvents": events, "displayTimeUnit": "ns"}, f)
+
+    sys.stderr.write("%d trace events written\n" % len(events))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
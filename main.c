@@ -21,6 +21,17 @@ static const eUSCI_UART_Config Uart115200Config =
     EUSCI_A_UART_OVERSAMPLING_BAUDRATE_GENERATION // Oversampling
 };
 
+/* Storage for the FIFOs */
+static joystickSample_t joystickBuffer[JOYSTICKFIFODEPTH];
+static uint16_t lightBuffer[LIGHTFIFODEPTH];
+static char *telemetryBuffer[TELEMETRYFIFODEPTH];
+
+/* Storage for the topics */
+static int32_t tempBuffer[TEMPTOPICDEPTH];
+
+/* Storage for the telemetry pool */
+static POOL_STORAGE(telemetryStorage, TELEMETRYBUFFERS, TELEMETRYBUFFERSIZE);
+
 /*
  * Initializes the USART
  */
@@ -47,41 +58,48 @@ void main(void)
     //Initializes UART
     uartInit();
 
-    //Initializing Semaphores
-    G8RTOS_InitSemaphore(&LEDMutex, 1);
-    G8RTOS_InitSemaphore(&sensorMutex, 1);
+    //Initializing Mutexes, holders inherit the priority of the threads they block
+    G8RTOS_InitMutex(&LEDMutex, MUTEX_NO_CEILING);
+    G8RTOS_InitMutex(&sensorMutex, MUTEX_NO_CEILING);
 
     //Adding background thread to scheduler
 
     //Reading temperature sensor
-    while(!(G8RTOS_AddThread(&bThread0) + 1));
+    while(!(G8RTOS_AddThread(&bThread0, SENSORPRIORITY, SENSORSTACKSIZE) + 1));
 
     //Read light sensor send through FIFO
-    while(!(G8RTOS_AddThread(&bThread1) + 1));
+    while(!(G8RTOS_AddThread(&bThread1, SENSORPRIORITY, SENSORSTACKSIZE) + 1));
 
     //Read FIFO, calculate RMS, set global
-    while(!(G8RTOS_AddThread(&bThread2) + 1));
+    while(!(G8RTOS_AddThread(&bThread2, CONSUMERPRIORITY, CONSUMERSTACKSIZE) + 1));
 
-    //Reading from TEMPFIFO and displaying on LED
-    while(!(G8RTOS_AddThread(&bThread3) + 1));
+    //Reading from temperature FIFO and displaying on LED
+    while(!(G8RTOS_AddThread(&bThread3, CONSUMERPRIORITY, CONSUMERSTACKSIZE) + 1));
 
     //Read Joy FIFO and output
-    while(!(G8RTOS_AddThread(&bThread4) + 1));
+    while(!(G8RTOS_AddThread(&bThread4, CONSUMERPRIORITY, CONSUMERSTACKSIZE) + 1));
 
-    //Empty loop
-    while(!(G8RTOS_AddThread(&bThread5) + 1));
+    //Transmit telemetry lines through UART
+    while(!(G8RTOS_AddThread(&bThread5, UARTPRIORITY, UARTSTACKSIZE) + 1));
 
     //Adding periodic thread to scheduler
-    //Joystick
-    while(!(G8RTOS_AddPeriodicEvent(&Pthread0, 100) + 1));
+    //Joystick, a late sample is taken once and the 100ms grid is kept
+    while(!(G8RTOS_AddPeriodicEvent(&Pthread0, 100, PERIODIC_COALESCE, PERIODIC_DEFERRED) + 1));
+
+    //UART print, a late print is dropped
+    while(!(G8RTOS_AddPeriodicEvent(&Pthread1, 1000, PERIODIC_SKIP, PERIODIC_DEFERRED) + 1));
 
+    //Create FIFOs, only Pthread0 writes the joystick FIFO and only bThread4 reads it
+    while(!(joystickFIFO = G8RTOS_CreateFIFO(joystickBuffer, JOYSTICKFIFODEPTH, sizeof(joystickSample_t), FIFO_SPSC, FIFO_DROP_NEWEST)));
+    while(!(lightFIFO = G8RTOS_CreateFIFO(lightBuffer, LIGHTFIFODEPTH, sizeof(uint16_t), FIFO_MPMC, FIFO_DROP_NEWEST)));
 
-    while(!(G8RTOS_AddPeriodicEvent(&Pthread1, 1000) + 1));
+    //Create topics, bThread3 subscribes before any thread runs so it gets every sample
+    while(!(tempTopic = G8RTOS_CreateTopic(TEMPTOPICNAME, tempBuffer, TEMPTOPICDEPTH, sizeof(int32_t))));
+    G8RTOS_Subscribe(&tempLEDSubscriber, tempTopic);
 
-    //Create FIFOs
-    while(!(G8RTOS_InitFIFO(JOYSTICKFIFO) + 1));
-    while(!(G8RTOS_InitFIFO(TEMPFIFO) + 1));
-    while(!(G8RTOS_InitFIFO(LIGHTFIFO) + 1 ));
+    //Telemetry lines are passed as pool buffers, so only the pointers go through the FIFO
+    G8RTOS_InitPool(&telemetryPool, telemetryStorage, TELEMETRYBUFFERS, TELEMETRYBUFFERSIZE);
+    while(!(telemetryFIFO = G8RTOS_CreateFIFO(telemetryBuffer, TELEMETRYFIFODEPTH, sizeof(char *), FIFO_MPMC, FIFO_DROP_NEWEST)));
 
     //Initialize GPIO pints at outputs
     //Configures the GPIO pins 3.5 3.7 5.1
@@ -24,6 +24,22 @@ uint32_t lightGlobal = 0;
 //Reads light FIFO
 uint32_t temperature = 0;
 
+//FIFOs
+fifoHandle_t joystickFIFO;
+fifoHandle_t lightFIFO;
+fifoHandle_t telemetryFIFO;
+
+//Topics
+topicHandle_t tempTopic;
+subscriber_t tempLEDSubscriber;
+
+//Buffers the UART lines are written into
+pool_t telemetryPool;
+
+//Mutexes used for LED and Sensor communication
+mutex_t sensorMutex;
+mutex_t LEDMutex;
+
 /* method to transmit a string through USART */
 static inline void uartTransmitString(char * s)
 {
@@ -43,11 +59,13 @@ static void rootMeanSquare(uint64_t n)
     uint64_t xk = n;
 
     //Newtons method to finding a square root
-    while(true)
+    //Integer estimates only go down until the root is reached, then they can swap between two values forever,
+    //so it stops at the first estimate that does not go down
+    while(xk != 0)
     {
         xk1 = (xk + (n / xk)) / 2;
 
-        if(abs(xk1-xk) < 1)
+        if(xk1 >= xk)
         {
             break;
         }
@@ -55,7 +73,7 @@ static void rootMeanSquare(uint64_t n)
     }
 
     //If Xrms is lower than 5000, set global to true
-    if(xk1 < 5000)
+    if(xk < 5000)
     {
         lightGlobal = 1;
     }
@@ -80,18 +98,19 @@ void bThread0(void)
         //Holds uncompressed data
         int32_t data;
 
-        //Waits for sensor I2C semaphore
-        G8RTOS_WaitSemaphore(&sensorMutex);
+        //Locks sensor I2C mutex
+        G8RTOS_LockMutex(&sensorMutex);
 
         while(bme280_read_uncomp_temperature(&data));
 
         //Releases Sensor
-        G8RTOS_SignalSemaphore(&sensorMutex);
+        G8RTOS_UnlockMutex(&sensorMutex);
 
-        //Interprets uncompressed data
-        int32_t temperature = bme280_compensate_temperature_int32(data);
+        //Interprets uncompressed data, which is in hundredths of a degree
+        int32_t temperature = bme280_compensate_temperature_int32(data) / 100;
 
-        int status = writeFIFO(TEMPFIFO, temperature/100);
+        //Every subscriber gets it, without bThread0 knowing who they are
+        G8RTOS_Publish(tempTopic, &temperature);
 
         //Toggle GPIO pin P5.1
         BITBAND_PERI(P5->OUT,1) = ~((P5->OUT & BIT1) >> 1);
@@ -115,16 +134,16 @@ void bThread1(void)
         //Reads accelerometer
         uint16_t light;
 
-        //Waits for sensor I2C semaphore
-        G8RTOS_WaitSemaphore(&sensorMutex);
+        //Locks sensor I2C mutex
+        G8RTOS_LockMutex(&sensorMutex);
 
         while(!sensorOpt3001Read(&light));
 
         //Releases Sensor
-        G8RTOS_SignalSemaphore(&sensorMutex);
+        G8RTOS_UnlockMutex(&sensorMutex);
 
         //Sends light data to FIFO
-        int status = writeFIFO(LIGHTFIFO, light);
+        int status = writeFIFO(lightFIFO, &light);
 
         //Toggle GPIO pin P2.3
         BITBAND_PERI(P2->OUT,3) = ~((P2->OUT & BIT3) >> 3);
@@ -148,38 +167,42 @@ void bThread2(void)
     //Array that holds past values
     uint64_t lightArray [lSize] = {0};
     uint8_t index = 0;
+
+    //Sum of the squares of the past values, kept up to date as values come and go
+    uint64_t n = 0;
     while(1)
     {
-        //Reads light FIFO
-        uint32_t light = readFIFO(LIGHTFIFO);
-
-        //Checks if index is greater than size, then
-        if(index >= lSize)
+        //Reads every light value waiting, if the light sensor stops producing the wait is tried again instead of hanging for good
+        uint16_t lights[lSize];
+        int32_t count = readFIFOBlock(lightFIFO, lights, 1, lSize, LIGHTTIMEOUTMS);
+        if(count <= 0)
         {
-            index = 0;
+            continue;
         }
 
-        //Saves data into index and increments
-        lightArray[index] = light;
-        index++;
-
-        //Holds value inside square root
-        uint64_t n = 0;
         int i;
-        for (i = 0; i < lSize; i++)
+        for (i = 0; i < count; i++)
         {
-            n += (lightArray[i]*lightArray[i]);
+            //Checks if index is greater than size, then
+            if(index >= lSize)
+            {
+                index = 0;
+            }
+
+            //Swaps the oldest value out of the sum and saves data into index and increments
+            n -= lightArray[index]*lightArray[index];
+            lightArray[index] = lights[i];
+            n += lightArray[index]*lightArray[index];
+            index++;
         }
 
-        n /= lSize; //FIX
-
-        //Calculates RMS value and sets global
-        rootMeanSquare(n);
+        //Calculates RMS value once for the batch and sets global
+        rootMeanSquare(n / lSize);
 
     }
 }
 /*
- * a. Read temperature FIFO
+ * a. Read temperature topic
     b. Output data to LEDs as shown in Figure B
  */
 void bThread3(void)
@@ -189,8 +212,10 @@ void bThread3(void)
 
     while(1)
     {
-        //Reads light FIFO
-        temperature = readFIFO(TEMPFIFO);
+        //Reads temperature topic
+        int32_t celsius;
+        G8RTOS_ReadTopic(&tempLEDSubscriber, &celsius, WAIT_FOREVER);
+        temperature = celsius;
         //Converts to Fahrenheit
         temperature = ((temperature * 9) / 5) + 32;
 
@@ -241,15 +266,15 @@ void bThread3(void)
             redLED = 0x0000;
         }
 
-        //Waits for LED I2C semaphore
-        G8RTOS_WaitSemaphore(&LEDMutex);
+        //Locks LED I2C mutex
+        G8RTOS_LockMutex(&LEDMutex);
 
         //Output values on LEDs
         LP3943_LedModeSet(BLUE, blueLED);
         LP3943_LedModeSet(RED,  redLED);
 
         //Releases Sensor
-        G8RTOS_SignalSemaphore(&LEDMutex);
+        G8RTOS_UnlockMutex(&LEDMutex);
     }
 }
 
@@ -266,10 +291,11 @@ void bThread4(void)
     while(1)
     {
         //Reads joystick FIFO
-        int32_t data = readFIFO(JOYSTICKFIFO);
+        joystickSample_t sample;
+        readFIFO(joystickFIFO, &sample);
 
         //Calculates decayed average value for coordinate X
-        avg = (avg + data) >> 1;
+        avg = (avg + sample.x) >> 1;
 
         if (avg > 6000)
         {
@@ -308,24 +334,16 @@ void bThread4(void)
             greenLED = 0x0F00;
         }
 
-        //Waits for LED I2C semaphore
-        G8RTOS_WaitSemaphore(&LEDMutex);
+        //Locks LED I2C mutex
+        G8RTOS_LockMutex(&LEDMutex);
 
         //Output the value on the green LED
         LP3943_LedModeSet(GREEN, greenLED);
 
         //Releases Sensor
-        G8RTOS_SignalSemaphore(&LEDMutex);
+        G8RTOS_UnlockMutex(&LEDMutex);
     }
 }
-/*
- *
- */
-void bThread5(void)
-{
-    while(1);
-}
-
 /* 100ms
  * a. Read X-coordinate from joystick
     b. Write data to Joystick FIFO
@@ -334,20 +352,21 @@ void bThread5(void)
  */
 void Pthread0(void)
 {
-    //Variables that will hold coordinates
-    int16_t x, y;
+    //Sample that will hold coordinates
+    joystickSample_t sample;
 
-    //Waits for sensor I2C semaphore
-    //G8RTOS_WaitSemaphore(&sensorMutex);
+    //Locks sensor I2C mutex
+    //G8RTOS_LockMutex(&sensorMutex);
 
     //Gets Joystick coordinates
-    GetJoystickCoordinates(&x, &y);
+    GetJoystickCoordinates(&sample.x, &sample.y);
+    sample.time = (uint32_t)G8RTOS_GetTimeMs();
 
     //Releases Sensor
-    //G8RTOS_SignalSemaphore(&sensorMutex);
+    //G8RTOS_UnlockMutex(&sensorMutex);
 
     //Sends joystick data to FIFO
-    int status = writeFIFO(JOYSTICKFIFO, x);
+    int status = writeFIFO(joystickFIFO, &sample);
 
     //Toggle GPIO pin P3.5
     BITBAND_PERI(P3->OUT,5) = ~((P3->OUT & BIT5) >> 5);
@@ -365,31 +384,38 @@ void Pthread1(void)
 {
     if(lightGlobal)
     {
-        //Reads light FIFO and calculates temperature in Farenheit
-        char str1[255];
-        char str2[255];
-
-        //Creates strings to print out
-        snprintf(str1, 255, "Temperature in Fahrenheit is: %d", temperature);
-        snprintf(str2, 255, "Decayed average value is: %d", avg);
-
-        //Transmits through Temperature
-        uartTransmitString(str1);
-
-        //New Line
-        char temp = 10;
-        uartTransmitString(&temp);
-        temp = 13;
-        uartTransmitString(&temp);
-
-        //Transmits decayed average value
-        uartTransmitString(str2);
-
-        //New Line
-        temp = 10;
-        uartTransmitString(&temp);
-        temp = 13;
-        uartTransmitString(&temp);
+        //Writes both lines into a pool buffer and hands it to bThread5, a print with no free buffer is dropped
+        char *lines = G8RTOS_AllocBuffer(&telemetryPool, 0);
+        if(lines == 0)
+        {
+            return;
+        }
+
+        //Creates strings to print out, temperature then decayed average value
+        snprintf(lines, TELEMETRYBUFFERSIZE, "Temperature in Fahrenheit is: %d\n\rDecayed average value is: %d\n\r", temperature, avg);
+
+        G8RTOS_SendBuffer(telemetryFIFO, lines, 0);
     }
     return;
 }
+
+/*
+ * a. Read telemetry FIFO
+    b. Transmit the lines through UART
+    c. Give the buffer back to the pool
+ */
+void bThread5(void)
+{
+    while(1)
+    {
+        //Waits for lines from Pthread1, the UART is slow so it is only ever waited on here
+        char *lines = G8RTOS_ReceiveBuffer(telemetryFIFO, WAIT_FOREVER);
+
+        //Trace thread sends its batches on the same UART
+        G8RTOS_LockMutex(&G8RTOS_BackChannelMutex);
+        uartTransmitString(lines);
+        G8RTOS_UnlockMutex(&G8RTOS_BackChannelMutex);
+
+        G8RTOS_ReleaseBuffer(lines);
+    }
+}
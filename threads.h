@@ -10,14 +10,56 @@
 
 #include <G8RTOS.h>
 
-//Defining MACROs for FIFOs
-#define JOYSTICKFIFO 0
-#define TEMPFIFO 1
-#define LIGHTFIFO 2
-
-//Semaphores used for LED and Sensor communication
-extern semaphore_t sensorMutex; //used for sensor
-extern semaphore_t LEDMutex; //used for displaying LEDs on board
+//Defining MACROs for FIFO depths, powers of two
+#define JOYSTICKFIFODEPTH 16
+#define LIGHTFIFODEPTH 16
+#define TELEMETRYFIFODEPTH 4
+
+//Temperature topic, any thread can find it by name and subscribe, depth is a power of two
+#define TEMPTOPICNAME "temperature"
+#define TEMPTOPICDEPTH 16
+
+//Buffers in the telemetry pool, and bytes in each, one 255 character print and its null
+#define TELEMETRYBUFFERS 4
+#define TELEMETRYBUFFERSIZE 256
+
+//Joystick sample sent through the joystick FIFO
+typedef struct
+{
+    int16_t x; //X-coordinate
+    int16_t y; //Y-coordinate
+    uint32_t time; //System time in ms it was taken at
+}joystickSample_t;
+
+//FIFOs, created in main
+extern fifoHandle_t joystickFIFO; //joystickSample_t, from Pthread0 to bThread4
+extern fifoHandle_t lightFIFO; //uint16_t light sensor reading
+extern fifoHandle_t telemetryFIFO; //telemetryPool buffers holding lines to print, from Pthread1 to bThread5
+
+//Topics, created in main
+extern topicHandle_t tempTopic; //int32_t temperature in Celsius, published by bThread0
+extern subscriber_t tempLEDSubscriber; //bThread3, subscribed in main so it gets the first sample
+
+//Pool the UART lines are written into, initialized in main
+extern pool_t telemetryPool;
+
+//Longest wait for light data, the light sensor writes every 200ms
+#define LIGHTTIMEOUTMS 1000
+
+//Defining MACROs for thread priorities, 0 is the highest
+#define CONSUMERPRIORITY 4 //Threads that read FIFOs
+#define SENSORPRIORITY 4 //Threads that read sensors and write FIFOs
+#define UARTPRIORITY 5 //Thread that transmits through UART, below the rest so its busy wait holds nothing up
+
+//Defining MACROs for thread stack sizes in bytes
+//Interrupts and periodic threads run on the main stack, so these only hold the thread's own calls
+#define CONSUMERSTACKSIZE 512
+#define SENSORSTACKSIZE 768
+#define UARTSTACKSIZE 512
+
+//Mutexes used for LED and Sensor communication
+extern mutex_t sensorMutex; //used for sensor
+extern mutex_t LEDMutex; //used for displaying LEDs on board
 
 //Background threads
 void bThread0(void);